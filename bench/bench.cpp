@@ -1,18 +1,153 @@
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
 #include <fstream>
 #include <iostream>
 #include <memory>
 #include <numeric>
 #include <random>
+#include <sstream>
 #include <string>
+#include <thread>
 
 #include "cmd_line_parser/parser.hpp"
 #include "essentials/essentials.hpp"
+#include "perf_counters.hpp"
 #include "tinyformat/tinyformat.h"
+#include "workload.hpp"
 
 static constexpr int SEARCH_RUNS = 10;
 static constexpr uint64_t NOT_FOUND = UINT64_MAX;
+static constexpr uint64_t UNSUPPORTED = UINT64_MAX - 1;
 static const char* TMP_INDEX_FILENAME = "tmp.bin";
 
+static std::vector<uint32_t> NUM_READER_THREADS;  // multi-threaded mode if not empty
+static uint64_t EVICTION_BYTES = uint64_t(64) << 20;  // for cold workloads
+static bool PERF_COUNTERS = false;  // report hardware performance counters
+static std::string OPERATIONS;  // optional operations to time besides lookup and decode
+static double PREDICTIVE_RATIO = 0.75;  // prefix of a query kept for predictive searches
+static uint64_t RANGE_LENGTH = 100;  // keys visited per range scan
+static uint64_t TOP_K = 10;  // completions returned per top-k query
+
+// Latency histogram in the style of HdrHistogram: values below 128 have their own bucket,
+// and larger values are kept with 6 significant bits (within 1.6% relative error).
+class latency_histogram {
+  public:
+    latency_histogram() : m_counts(64 * 58 + 128, 0) {}
+
+    void add(uint64_t value) {
+        m_counts[bucket_of(value)] += 1;
+        m_total += 1;
+        m_max = std::max(m_max, value);
+    }
+    void merge(const latency_histogram& other) {
+        for (size_t i = 0; i < m_counts.size(); i++) {
+            m_counts[i] += other.m_counts[i];
+        }
+        m_total += other.m_total;
+        m_max = std::max(m_max, other.m_max);
+    }
+
+    // Returns the upper bound of the bucket holding the q-quantile (0 < q <= 1).
+    uint64_t quantile(double q) const {
+        const uint64_t rank = std::max<uint64_t>(1, uint64_t(std::ceil(q * m_total)));
+        uint64_t seen = 0;
+        for (size_t i = 0; i < m_counts.size(); i++) {
+            seen += m_counts[i];
+            if (seen >= rank) {
+                return std::min(upper_bound_of(i), m_max);
+            }
+        }
+        return m_max;
+    }
+    uint64_t max() const {
+        return m_max;
+    }
+
+  private:
+    std::vector<uint64_t> m_counts;
+    uint64_t m_total = 0;
+    uint64_t m_max = 0;
+
+    static size_t bucket_of(uint64_t value) {
+        if (value < 128) {
+            return value;
+        }
+        const uint64_t shift = 63 - __builtin_clzll(value) - 6;
+        return 64 * shift + (value >> shift);
+    }
+    static uint64_t upper_bound_of(size_t bucket) {
+        if (bucket < 128) {
+            return bucket;
+        }
+        const uint64_t shift = bucket / 64 - 1;
+        return (((bucket - 64 * shift) + 1) << shift) - 1;
+    }
+};
+
+// Returns a field of /proc/self/status (such as "VmRSS" or "VmHWM") in bytes, or 0 if unavailable.
+uint64_t read_proc_status(const char* field) {
+    std::ifstream ifs("/proc/self/status");
+    const std::string prefix = std::string(field) + ":";
+    for (std::string line; std::getline(ifs, line);) {
+        if (line.compare(0, prefix.size(), prefix) == 0) {
+            return std::stoull(line.substr(prefix.size())) * 1024;  // in kB
+        }
+    }
+    return 0;
+}
+
+// Resets the peak RSS (VmHWM) to the current RSS, which is supported since Linux 4.0.
+void reset_peak_rss() {
+    std::ofstream ofs("/proc/self/clear_refs");
+    ofs << "5";
+}
+
+uint64_t get_peak_rss() {
+    const uint64_t peak = read_proc_status("VmHWM");
+    if (peak != 0) {
+        return peak;
+    }
+    struct rusage usage;  // not resettable, so it may include earlier peaks
+    getrusage(RUSAGE_SELF, &usage);
+    return uint64_t(usage.ru_maxrss) * 1024;
+}
+
+// Evicts the file from the page cache so that the next read goes to the storage.
+void drop_page_cache(const char* filename) {
+    const int fd = open(filename, O_RDONLY);
+    if (fd < 0) {
+        return;
+    }
+    fdatasync(fd);
+    posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    close(fd);
+}
+
+void pin_to_core(uint32_t core) {
+#ifdef __linux__
+    cpu_set_t cpuset;
+    CPU_ZERO(&cpuset);
+    CPU_SET(core % std::thread::hardware_concurrency(), &cpuset);
+    pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpuset);
+#endif
+}
+
+std::vector<std::string> split_list(const std::string& str) {
+    std::vector<std::string> tokens;
+    std::istringstream iss(str);
+    for (std::string token; std::getline(iss, token, ',');) {
+        tokens.push_back(token);
+    }
+    return tokens;
+}
+
 std::vector<std::string> load_strings(const std::string& filepath, bool to_unique) {
     std::ifstream ifs(filepath);
     if (!ifs) {
@@ -29,17 +164,6 @@ std::vector<std::string> load_strings(const std::string& filepath, bool to_uniqu
     }
     return strings;
 }
-std::vector<std::string> sample_strings(const std::vector<std::string>& strings, std::uint64_t num_samples,
-                                        std::uint64_t random_seed) {
-    std::mt19937_64 engine(random_seed);
-    std::uniform_int_distribution<std::uint64_t> dist(0, strings.size() - 1);
-
-    std::vector<std::string> sampled(num_samples);
-    for (std::uint64_t i = 0; i < num_samples; i++) {
-        sampled[i] = strings[dist(engine)];
-    }
-    return sampled;
-}
 
 template <class T>
 std::unique_ptr<T> build(std::vector<std::string>&);
@@ -48,15 +172,58 @@ uint64_t lookup(T*, const std::string&);
 template <class T>
 uint64_t decode(T*, uint64_t);
 template <class T>
-uint64_t get_memory(T*);
+uint64_t get_memory(T*);  // the size of TMP_INDEX_FILENAME, written by the call
+template <class T>
+std::unique_ptr<T> load(const char*);
+template <class T>
+uint64_t get_memory_usage(T*) {  // in-memory size reported by the library, or 0 if unknown
+    return 0;
+}
+// Optional operations returning the number of keys found, or UNSUPPORTED.
+// Every operation materializes the keys (or their lengths) in the way the library offers.
+template <class T>
+uint64_t common_prefix(T*, const std::string&) {  // keys that are prefixes of the query
+    return UNSUPPORTED;
+}
+template <class T>
+uint64_t predictive(T*, const std::string&) {  // keys starting with the query
+    return UNSUPPORTED;
+}
+template <class T>
+uint64_t range_scan(T*, const std::string&, uint64_t) {  // up to n keys in order from the query
+    return UNSUPPORTED;
+}
+template <class T>
+uint64_t count_prefix(T*, const std::string&) {  // keys starting with the query, without enumerating them
+    return UNSUPPORTED;
+}
+template <class T>
+uint64_t top_k(T*, const std::string&, uint64_t) {  // the k heaviest keys starting with the query
+    return UNSUPPORTED;
+}
 
 #ifdef USE_FST
 #include <fst.hpp>
+#include <fst/top_k.hpp>
 using trie_t = fst::Trie;
 static const uint32_t SPARSE_DENSE_RATIO = 16;
+static bool PACK_INTO_ARENA = false;
+static uint32_t BLOOM_BITS_PER_KEY = 0;
+static uint32_t FINGERPRINT_BITS = 0;
+static uint32_t INLINE_TAIL_BYTES = 0;
+static bool RANK_SELECT = false;
 template <>
 std::unique_ptr<trie_t> build(std::vector<std::string>& keys) {
-    auto trie = std::make_unique<trie_t>(keys, true, SPARSE_DENSE_RATIO);
+    fst::Config config;
+    config.sparse_dense_ratio = SPARSE_DENSE_RATIO;
+    config.bloom_bits_per_key = BLOOM_BITS_PER_KEY;
+    config.fingerprint_bits = FINGERPRINT_BITS;
+    config.inline_tail_bytes = INLINE_TAIL_BYTES;
+    config.rank_select = RANK_SELECT;
+    auto trie = std::make_unique<trie_t>(keys, config);
+    if (PACK_INTO_ARENA) {
+        trie->packIntoArena();
+    }
     return trie;
 }
 template <>
@@ -74,6 +241,202 @@ uint64_t get_memory(trie_t* trie) {
     trie->save(ofs);
     return essentials::file_size(TMP_INDEX_FILENAME);
 }
+template <>
+std::unique_ptr<trie_t> load(const char* filename) {
+    auto trie = std::make_unique<trie_t>();
+    std::ifstream ifs(filename);
+    trie->load(ifs);
+    if (PACK_INTO_ARENA) {
+        trie->packIntoArena();
+    }
+    return trie;
+}
+template <>
+uint64_t get_memory_usage(trie_t* trie) {
+    return trie->getMemoryUsage();
+}
+template <>
+uint64_t common_prefix(trie_t* trie, const std::string& query) {
+    uint64_t num = 0;
+    trie->commonPrefixSearch(query, [&](fst::position_t, size_t) { ++num; });
+    return num;
+}
+template <>
+uint64_t predictive(trie_t* trie, const std::string& query) {
+    uint64_t num = 0;
+    for (auto it = trie->predictiveSearch(query); it.isValid(); it++) {
+        ++num;
+    }
+    return num;
+}
+template <>
+uint64_t range_scan(trie_t* trie, const std::string& query, uint64_t n) {
+    uint64_t num = 0;
+    for (auto it = trie->lowerBound(query); it.isValid() && num < n; it++) {
+        ++num;
+    }
+    return num;
+}
+template <>
+uint64_t count_prefix(trie_t* trie, const std::string& query) {
+    return trie->hasRankSelect() ? trie->countPrefix(query) : UNSUPPORTED;
+}
+template <>
+uint64_t top_k(trie_t* trie, const std::string& query, uint64_t k) {
+    // random weights, assigned when the trie is first queried
+    static const trie_t* weighted_trie = nullptr;
+    static std::unique_ptr<fst::TopKCompleter> completer;
+    if (!trie->hasRankSelect()) {
+        return UNSUPPORTED;
+    }
+    if (weighted_trie != trie) {
+        std::mt19937 engine(13);
+        std::vector<uint32_t> weights(trie->getNumKeyIds());
+        for (auto& weight : weights) {
+            weight = uint32_t(engine());
+        }
+        completer = std::make_unique<fst::TopKCompleter>(*trie, weights);
+        weighted_trie = trie;
+    }
+    return completer->topK(query, k).size();
+}
+// Prints the trie shape and the histograms of traversal counters over the queries.
+void dump_traversal_stats(std::vector<std::string>& keys, const std::vector<std::string>& queries) {
+    auto trie = build<trie_t>(keys);
+    surf::TraversalStats stats;
+    for (const auto& query : queries) {
+        trie->exactSearch(query, stats);
+    }
+    std::cout << "{\"height\": " << trie->getHeight() << ", \"sparse_start_level\": " << trie->getSparseStartLevel()
+              << ", \"num_nodes\": " << trie->getNumNodes() << ", \"stats\": ";
+    stats.dump(std::cout);
+    std::cout << "}" << std::endl;
+}
+// Builds the trie for every combination of the parameters (a ratio of 0 means no LoudsDense) and
+// prints a line per combination, flagging the Pareto frontier of space and lookup time.
+void sweep_configs(std::vector<std::string>& keys, const workload& w, const std::vector<uint32_t>& ratios,
+                   const std::vector<uint32_t>& rank_block_sizes, const std::vector<uint32_t>& select_intervals) {
+    struct point {
+        essentials::json_lines logger;
+        uint64_t memory;
+        double lookup_ns;
+    };
+    std::vector<point> points;
+    for (const uint32_t ratio : ratios) {
+        for (const uint32_t rank_block_size : rank_block_sizes) {
+            for (const uint32_t select_interval : select_intervals) {
+                fst::Config config;
+                config.include_dense = ratio != 0;
+                config.sparse_dense_ratio = std::max<uint32_t>(ratio, 1);
+                config.rank_block_size = rank_block_size;
+                config.select_sample_interval = select_interval;
+                config.bloom_bits_per_key = BLOOM_BITS_PER_KEY;
+                config.fingerprint_bits = FINGERPRINT_BITS;
+                config.inline_tail_bytes = INLINE_TAIL_BYTES;
+
+                auto trie = std::make_unique<trie_t>(keys, config);
+                if (PACK_INTO_ARENA) {
+                    trie->packIntoArena();
+                }
+                essentials::json_lines logger;
+                logger.add("name", "FST_SWEEP");
+                logger.add("include_dense", config.include_dense ? "true" : "false");
+                logger.add("sparse_dense_ratio", config.sparse_dense_ratio);
+                logger.add("rank_block_size", rank_block_size);
+                logger.add("select_sample_interval", select_interval);
+                logger.add("sparse_start_level", trie->getSparseStartLevel());
+                logger.add("workload", w.name.c_str());
+
+                essentials::timer<essentials::clock_type, std::chrono::nanoseconds> tm;
+                for (int i = 0; i <= SEARCH_RUNS; ++i) {
+                    uint64_t num_misses = 0;
+                    tm.start();
+                    for (const auto& query : w.queries) {
+                        num_misses += lookup(trie.get(), query) == NOT_FOUND;
+                    }
+                    tm.stop();
+                    if (num_misses != w.num_misses) {
+                        tfm::errorfln("Unexpected number of misses: %d (expected %d)", num_misses, w.num_misses);
+                        return;
+                    }
+                }
+                tm.discard_first();  // for warming up
+                const double lookup_ns = tm.min() / w.queries.size();
+                logger.add("lookup_ns_per_query", tm.average() / w.queries.size());
+                logger.add("best_lookup_ns_per_query", lookup_ns);
+
+                const uint64_t mem = get_memory(trie.get());
+                logger.add("memory_in_bytes", mem);
+                points.push_back({logger, mem, lookup_ns});
+            }
+        }
+    }
+    for (auto& p : points) {
+        const bool dominated = std::any_of(points.begin(), points.end(), [&](const point& q) {
+            return q.memory <= p.memory && q.lookup_ns <= p.lookup_ns &&
+                   (q.memory < p.memory || q.lookup_ns < p.lookup_ns);
+        });
+        p.logger.add("pareto_optimal", dominated ? "false" : "true");
+        p.logger.print();
+    }
+}
+// Runs the miss workload at every miss ratio on the trie with every number of Bloom filter bits
+// per key (0 means no filter), printing a line per combination.
+void sweep_bloom(std::vector<std::string>& keys, const workload_options& opts, const std::vector<double>& miss_ratios,
+                 const std::vector<uint32_t>& bloom_bits) {
+    std::vector<workload> workloads;
+    for (const double miss_ratio : miss_ratios) {
+        workload_options miss_opts = opts;
+        miss_opts.miss_ratio = miss_ratio;
+        workloads.push_back(make_workload("miss", keys, miss_opts));
+    }
+    for (const uint32_t bits_per_key : bloom_bits) {
+        fst::Config config;
+        config.sparse_dense_ratio = SPARSE_DENSE_RATIO;
+        config.bloom_bits_per_key = bits_per_key;
+        config.fingerprint_bits = FINGERPRINT_BITS;
+        config.inline_tail_bytes = INLINE_TAIL_BYTES;
+        auto trie = std::make_unique<trie_t>(keys, config);
+        if (PACK_INTO_ARENA) {
+            trie->packIntoArena();
+        }
+        const uint64_t mem = get_memory(trie.get());
+
+        for (size_t i = 0; i < workloads.size(); i++) {
+            const auto& w = workloads[i];
+            essentials::json_lines logger;
+            logger.add("name", "FST_BLOOM");
+            logger.add("bloom_bits_per_key", bits_per_key);
+            logger.add("miss_ratio", miss_ratios[i]);
+
+            surf::TraversalStats stats;
+            for (const auto& query : w.queries) {
+                trie->exactSearch(query, stats);
+            }
+            const uint64_t num_rejects = stats.getHistogram(surf::TraversalStats::kBloomRejects).getSum();
+            logger.add("bloom_reject_ratio", w.num_misses != 0 ? double(num_rejects) / w.num_misses : 0.0);
+
+            essentials::timer<essentials::clock_type, std::chrono::nanoseconds> tm;
+            for (int run = 0; run <= SEARCH_RUNS; ++run) {
+                uint64_t num_misses = 0;
+                tm.start();
+                for (const auto& query : w.queries) {
+                    num_misses += lookup(trie.get(), query) == NOT_FOUND;
+                }
+                tm.stop();
+                if (num_misses != w.num_misses) {
+                    tfm::errorfln("Unexpected number of misses: %d (expected %d)", num_misses, w.num_misses);
+                    return;
+                }
+            }
+            tm.discard_first();  // for warming up
+            logger.add("lookup_ns_per_query", tm.average() / w.queries.size());
+            logger.add("best_lookup_ns_per_query", tm.min() / w.queries.size());
+            logger.add("memory_in_bytes", mem);
+            logger.print();
+        }
+    }
+}
 #endif
 
 #ifdef USE_DARTS
@@ -111,6 +474,22 @@ uint64_t get_memory(trie_t* trie) {
     trie->save(TMP_INDEX_FILENAME);
     return essentials::file_size(TMP_INDEX_FILENAME);
 }
+template <>
+std::unique_ptr<trie_t> load(const char* filename) {
+    auto trie = std::make_unique<trie_t>();
+    trie->open(filename);
+    return trie;
+}
+template <>
+uint64_t get_memory_usage(trie_t* trie) {
+    return trie->total_size();
+}
+template <>
+uint64_t common_prefix(trie_t* trie, const std::string& query) {
+    static thread_local trie_t::result_pair_type results[256];
+    const size_t num = trie->commonPrefixSearch(query.c_str(), results, 256, query.length());
+    return std::min<size_t>(num, 256);
+}
 #endif
 
 #ifdef USE_CEDAR
@@ -143,6 +522,39 @@ uint64_t get_memory(trie_t* trie) {
     trie->save(TMP_INDEX_FILENAME);
     return essentials::file_size(TMP_INDEX_FILENAME);
 }
+template <>
+std::unique_ptr<trie_t> load(const char* filename) {
+    auto trie = std::make_unique<trie_t>();
+    trie->open(filename);
+    return trie;
+}
+template <>
+uint64_t get_memory_usage(trie_t* trie) {
+    return trie->total_size();
+}
+template <>
+uint64_t common_prefix(trie_t* trie, const std::string& query) {
+    static thread_local trie_t::result_pair_type results[256];
+    const size_t num = trie->commonPrefixSearch(query.c_str(), results, 256, query.length());
+    return std::min<size_t>(num, 256);
+}
+template <>
+uint64_t predictive(trie_t* trie, const std::string& query) {
+    static thread_local std::vector<trie_t::result_triple_type> results(1024);
+    static thread_local std::vector<char> key;
+    size_t num = trie->commonPrefixPredict(query.c_str(), results.data(), results.size(), query.length());
+    if (num > results.size()) {
+        results.resize(num);
+        num = trie->commonPrefixPredict(query.c_str(), results.data(), results.size(), query.length());
+    }
+    // restores the keys from the nodes, as the values are not key ids
+    for (size_t i = 0; i < num; ++i) {
+        key.resize(query.length() + results[i].length + 1);
+        std::copy(query.begin(), query.end(), key.begin());
+        trie->suffix(key.data() + query.length(), results[i].length, results[i].id);
+    }
+    return num;
+}
 #endif
 
 #ifdef USE_DASTRIE
@@ -184,6 +596,21 @@ template <>
 uint64_t get_memory(trie_t* trie) {
     return essentials::file_size(TMP_INDEX_FILENAME);
 }
+template <>
+std::unique_ptr<trie_t> load(const char* filename) {
+    std::ifstream ifs(filename, std::ios::binary);
+    auto trie = std::make_unique<trie_t>();
+    trie->read(ifs);
+    return trie;
+}
+template <>
+uint64_t common_prefix(trie_t* trie, const std::string& query) {
+    uint64_t num = 0;
+    for (auto cursor = trie->prefix(query.c_str()); cursor.next();) {
+        ++num;
+    }
+    return num;
+}
 #endif
 
 #ifdef USE_TX
@@ -201,7 +628,7 @@ std::unique_ptr<trie_t> build(std::vector<std::string>& keys) {
 }
 template <>
 uint64_t lookup(trie_t* trie, const std::string& query) {
-    static size_t retLen = 0;
+    static thread_local size_t retLen = 0;
     auto res = trie->prefixSearch(query.c_str(), query.length(), retLen);
     return res != tx_tool::tx::NOTFOUND ? uint64_t(res) : NOT_FOUND;
 }
@@ -215,6 +642,28 @@ template <>
 uint64_t get_memory(trie_t*) {
     return essentials::file_size(TMP_INDEX_FILENAME);
 }
+template <>
+std::unique_ptr<trie_t> load(const char* filename) {
+    auto trie = std::make_unique<trie_t>();
+    trie->read(filename);
+    return trie;
+}
+template <>
+uint64_t common_prefix(trie_t* trie, const std::string& query) {
+    static thread_local std::vector<std::string> ret;
+    static thread_local std::vector<tx_tool::uint> ret_ids;
+    ret.clear();
+    ret_ids.clear();
+    return trie->commonPrefixSearch(query.c_str(), query.length(), ret, ret_ids);
+}
+template <>
+uint64_t predictive(trie_t* trie, const std::string& query) {
+    static thread_local std::vector<std::string> ret;
+    static thread_local std::vector<tx_tool::uint> ret_ids;
+    ret.clear();
+    ret_ids.clear();
+    return trie->predictiveSearch(query.c_str(), query.length(), ret, ret_ids);
+}
 #endif
 
 #ifdef USE_MARISA
@@ -232,7 +681,7 @@ std::unique_ptr<trie_t> build(std::vector<std::string>& keys) {
 }
 template <>
 uint64_t lookup(trie_t* trie, const std::string& query) {
-    static marisa::Agent agent;
+    static thread_local marisa::Agent agent;
     agent.set_query(query.c_str(), query.length());
     return trie->lookup(agent) ? uint64_t(agent.key().id()) : NOT_FOUND;
 }
@@ -248,6 +697,36 @@ uint64_t get_memory(trie_t* trie) {
     trie->save(TMP_INDEX_FILENAME);
     return essentials::file_size(TMP_INDEX_FILENAME);
 }
+template <>
+std::unique_ptr<trie_t> load(const char* filename) {
+    auto trie = std::make_unique<trie_t>();
+    trie->load(filename);
+    return trie;
+}
+template <>
+uint64_t get_memory_usage(trie_t* trie) {
+    return trie->total_size();
+}
+template <>
+uint64_t common_prefix(trie_t* trie, const std::string& query) {
+    static thread_local marisa::Agent agent;
+    agent.set_query(query.c_str(), query.length());
+    uint64_t num = 0;
+    while (trie->common_prefix_search(agent)) {
+        ++num;
+    }
+    return num;
+}
+template <>
+uint64_t predictive(trie_t* trie, const std::string& query) {
+    static thread_local marisa::Agent agent;
+    agent.set_query(query.c_str(), query.length());
+    uint64_t num = 0;
+    while (trie->predictive_search(agent)) {
+        ++num;
+    }
+    return num;
+}
 #endif
 
 #ifdef USE_XCDAT_7
@@ -288,9 +767,26 @@ uint64_t get_memory(trie_t* trie) {
     xcdat::save(*trie, TMP_INDEX_FILENAME);
     return essentials::file_size(TMP_INDEX_FILENAME);
 }
+template <>
+std::unique_ptr<trie_t> load(const char* filename) {
+    return std::make_unique<trie_t>(xcdat::load<trie_t>(filename));
+}
+template <>
+uint64_t common_prefix(trie_t* trie, const std::string& query) {
+    uint64_t num = 0;
+    trie->prefix_search(query, [&](uint64_t, std::string_view) { ++num; });
+    return num;
+}
+template <>
+uint64_t predictive(trie_t* trie, const std::string& query) {
+    uint64_t num = 0;
+    trie->predictive_search(query, [&](uint64_t, std::string_view) { ++num; });
+    return num;
+}
 #endif
 
 #ifdef USE_PDT
+#include <boost/iostreams/device/mapped_file.hpp>
 #include <succinct/mapper.hpp>
 #include <tries/compressed_string_pool.hpp>
 #include <tries/path_decomposed_trie.hpp>
@@ -314,6 +810,15 @@ uint64_t get_memory(trie_t* trie) {
     succinct::mapper::freeze(*trie, TMP_INDEX_FILENAME);
     return essentials::file_size(TMP_INDEX_FILENAME);
 }
+template <>
+std::unique_ptr<trie_t> load(const char* filename) {
+    // The trie refers to the mapped file, which is kept until the next load.
+    static std::unique_ptr<boost::iostreams::mapped_file_source> mapped;
+    auto trie = std::make_unique<trie_t>();
+    mapped = std::make_unique<boost::iostreams::mapped_file_source>(filename);
+    succinct::mapper::map(*trie, mapped->data());
+    return trie;
+}
 #endif
 
 #ifdef USE_HATTRIE
@@ -343,6 +848,25 @@ class serializer {
   private:
     std::ofstream m_ostream;
 };
+class deserializer {
+  public:
+    deserializer(const char* file_name) {
+        m_istream.exceptions(m_istream.badbit | m_istream.failbit | m_istream.eofbit);
+        m_istream.open(file_name);
+    }
+    template <class T, typename std::enable_if<std::is_arithmetic<T>::value>::type* = nullptr>
+    T operator()() {
+        T value;
+        m_istream.read(reinterpret_cast<char*>(&value), sizeof(T));
+        return value;
+    }
+    void operator()(char* value_out, std::size_t value_size) {
+        m_istream.read(value_out, value_size);
+    }
+
+  private:
+    std::ifstream m_istream;
+};
 template <>
 std::unique_ptr<trie_t> build(std::vector<std::string>& keys) {
     auto trie = std::make_unique<trie_t>();
@@ -366,48 +890,263 @@ uint64_t get_memory(trie_t* trie) {
     trie->serialize(serial);
     return essentials::file_size(TMP_INDEX_FILENAME);
 }
+template <>
+std::unique_ptr<trie_t> load(const char* filename) {
+    deserializer dserial(filename);
+    return std::make_unique<trie_t>(trie_t::deserialize(dserial));
+}
+#ifdef USE_HATTRIE
+template <>
+uint64_t predictive(trie_t* trie, const std::string& query) {
+    uint64_t num = 0;
+    static thread_local std::string key;
+    const auto range = trie->equal_prefix_range(query);  // unordered, unlike the other tries
+    for (auto it = range.first; it != range.second; ++it) {
+        it.key(key);
+        ++num;
+    }
+    return num;
+}
 #endif
+#endif
+
+// Runs fn(t) in N threads pinned to distinct cores, released together once all of them are ready.
+// Returns the wall-clock seconds from the release until the last thread finishes.
+template <class Fn>
+double run_pinned_threads(uint32_t num_threads, Fn fn) {
+    std::atomic<uint32_t> num_ready{0};
+    std::atomic<bool> go{false};
+
+    std::vector<std::thread> threads;
+    for (uint32_t t = 0; t < num_threads; t++) {
+        threads.emplace_back([&, t]() {
+            pin_to_core(t);
+            num_ready.fetch_add(1);
+            while (!go.load(std::memory_order_acquire)) {
+                std::this_thread::yield();
+            }
+            fn(t);
+        });
+    }
+
+    while (num_ready.load() != num_threads) {
+        std::this_thread::yield();
+    }
+    const auto start = std::chrono::steady_clock::now();
+    go.store(true, std::memory_order_release);
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    const auto stop = std::chrono::steady_clock::now();
+    return std::chrono::duration<double>(stop - start).count();
+}
+
+// N reader threads search the shared trie concurrently, each running SEARCH_RUNS passes over the
+// queries from its own starting offset. The throughput pass has no per-query timers; a second pass
+// times every query for the latency percentiles. Misses are counted per thread and summed after
+// the join, so that the threads share no written cache line.
+template <class T>
+void concurrent_lookup_template(const char* title, T* trie, const workload& w, uint32_t num_threads,
+                                essentials::json_lines& logger) {
+    const std::vector<std::string>& queries = w.queries;
+    std::vector<uint64_t> num_misses(num_threads);
+    auto check_misses = [&]() {
+        const uint64_t total = std::accumulate(num_misses.begin(), num_misses.end(), uint64_t(0));
+        if (total != w.num_misses * SEARCH_RUNS * num_threads) {
+            tfm::errorfln("Unexpected number of misses: %d in %d threads", total, num_threads);
+            return false;
+        }
+        return true;
+    };
+
+    const double seconds = run_pinned_threads(num_threads, [&](uint32_t t) {
+        const size_t offset = queries.size() * t / num_threads;
+        uint64_t misses = 0;
+        for (int r = 0; r < SEARCH_RUNS; ++r) {
+            for (size_t i = 0; i < queries.size(); i++) {
+                if (lookup(trie, queries[(offset + i) % queries.size()]) == NOT_FOUND) {
+                    misses++;
+                }
+            }
+        }
+        num_misses[t] = misses;
+    });
+    if (!check_misses()) {
+        return;
+    }
+
+    std::vector<latency_histogram> histograms(num_threads);
+    run_pinned_threads(num_threads, [&](uint32_t t) {
+        latency_histogram& hist = histograms[t];
+        const size_t offset = queries.size() * t / num_threads;
+        uint64_t misses = 0;
+        for (int r = 0; r < SEARCH_RUNS; ++r) {
+            for (size_t i = 0; i < queries.size(); i++) {
+                const auto& query = queries[(offset + i) % queries.size()];
+                const auto start = std::chrono::steady_clock::now();
+                const uint64_t res = lookup(trie, query);
+                const auto stop = std::chrono::steady_clock::now();
+                hist.add(std::chrono::duration_cast<std::chrono::nanoseconds>(stop - start).count());
+                if (res == NOT_FOUND) {
+                    misses++;
+                }
+            }
+        }
+        num_misses[t] = misses;
+    });
+    if (!check_misses()) {
+        return;
+    }
+
+    latency_histogram total;
+    for (const auto& hist : histograms) {
+        total.merge(hist);
+    }
+    const double num_lookups = double(queries.size()) * SEARCH_RUNS * num_threads;
+
+    logger.new_line();
+    logger.add("name", title);
+    logger.add("workload", w.name.c_str());
+    logger.add("num_threads", num_threads);
+    logger.add("queries_per_sec", num_lookups / seconds);
+    logger.add("p50_ns", total.quantile(0.5));
+    logger.add("p90_ns", total.quantile(0.9));
+    logger.add("p99_ns", total.quantile(0.99));
+    logger.add("p999_ns", total.quantile(0.999));
+    logger.add("max_ns", total.max());
+}
+
+// Returns false if the number of misses differs from the expected one.
+template <class T>
+bool lookup_template(T* trie, const workload& w, essentials::json_lines& logger) {
+    const std::vector<std::string>& queries = w.queries;
+    logger.add("workload", w.name.c_str());
+
+    perf_counters counters(PERF_COUNTERS);
+
+    if (w.cold) {
+        cache_evictor evictor(EVICTION_BYTES);
+        uint64_t total_ns = 0;
+        uint64_t num_misses = 0;
+        counters.start();
+        counters.pause();
+        for (const auto& query : queries) {
+            evictor.evict();
+            counters.resume();
+            const auto start = std::chrono::steady_clock::now();
+            num_misses += lookup(trie, query) == NOT_FOUND;
+            const auto stop = std::chrono::steady_clock::now();
+            counters.pause();
+            total_ns += std::chrono::duration_cast<std::chrono::nanoseconds>(stop - start).count();
+        }
+        counters.stop();
+        if (num_misses != w.num_misses) {
+            tfm::errorfln("Unexpected number of misses: %d (expected %d)", num_misses, w.num_misses);
+            return false;
+        }
+        logger.add("lookup_ns_per_query", double(total_ns) / queries.size());
+        counters.add_to(logger, "lookup", "query", queries.size());
+        return true;
+    }
+
+    essentials::timer<essentials::clock_type, std::chrono::nanoseconds> tm;
+    for (int i = 0; i <= SEARCH_RUNS; ++i) {
+        uint64_t num_misses = 0;
+        if (i == 1) {
+            counters.start();  // after warming up
+        }
+        tm.start();
+        for (const auto& query : queries) {
+            num_misses += lookup(trie, query) == NOT_FOUND;
+        }
+        tm.stop();
+        if (num_misses != w.num_misses) {
+            tfm::errorfln("Unexpected number of misses: %d (expected %d)", num_misses, w.num_misses);
+            return false;
+        }
+    }
+    counters.stop();
+    tm.discard_first();  // for warming up
+    logger.add("lookup_ns_per_query", tm.average() / queries.size());
+    logger.add("best_lookup_ns_per_query", tm.min() / queries.size());
+    counters.add_to(logger, "lookup", "query", queries.size() * SEARCH_RUNS);
+    return true;
+}
+
+// Times an optional operation over the queries of the first workload, in a separate line.
+// Nothing is reported if the library does not support the operation.
+template <class T, class Op>
+void operation_template(const char* title, const char* operation, T* trie, const std::vector<std::string>& queries,
+                        essentials::json_lines& logger, Op op) {
+    if (op(trie, queries[0]) == UNSUPPORTED) {
+        return;
+    }
+    uint64_t num_results = 0;
+    essentials::timer<essentials::clock_type, std::chrono::nanoseconds> tm;
+    for (int i = 0; i <= SEARCH_RUNS; ++i) {
+        num_results = 0;
+        tm.start();
+        for (const auto& query : queries) {
+            num_results += op(trie, query);
+        }
+        tm.stop();
+    }
+    tm.discard_first();  // for warming up
+    logger.new_line();
+    logger.add("name", title);
+    logger.add("operation", operation);
+    logger.add("ns_per_query", tm.average() / queries.size());
+    logger.add("best_ns_per_query", tm.min() / queries.size());
+    // the same for all the libraries (up to range_scan), which serves as a check; count_prefix
+    // gives the same as predictive
+    logger.add("results_per_query", double(num_results) / queries.size());
+}
 
+// The first line has the results of the build, the first workload, decoding and memory usage.
+// The other workloads, the multi-threaded runs and the optional operations follow in separate lines.
 template <class T>
-void main_template(const char* title, std::vector<std::string>& keys, std::vector<std::string>& queries,
+void main_template(const char* title, std::vector<std::string>& keys, const std::vector<workload>& workloads,
                    bool run_decode) {
     essentials::json_lines logger;
     logger.add("name", title);
 
     std::unique_ptr<T> trie;
     {
+        reset_peak_rss();
+        const uint64_t rss = read_proc_status("VmRSS");
+        perf_counters counters(PERF_COUNTERS);
         essentials::timer<essentials::clock_type, std::chrono::nanoseconds> tm;
+        counters.start();
         tm.start();
         trie = build<T>(keys);
         tm.stop();
+        counters.stop();
         logger.add("build_ns_per_key", tm.average() / keys.size());
+        counters.add_to(logger, "build", "key", keys.size());
+        logger.add("build_peak_rss_in_bytes", get_peak_rss());
+        logger.add("build_peak_rss_increase_in_bytes", get_peak_rss() - rss);
+        logger.add("rss_increase_in_bytes", read_proc_status("VmRSS") - rss);
     }
 
-    {
-        essentials::timer<essentials::clock_type, std::chrono::nanoseconds> tm;
-        for (int i = 0; i <= SEARCH_RUNS; ++i) {
-            tm.start();
-            for (const auto& query : queries) {
-                if (lookup(trie.get(), query) == NOT_FOUND) {
-                    tfm::errorfln("Not found: %s", query);
-                    return;
-                }
-            }
-            tm.stop();
-        }
-        tm.discard_first();  // for warming up
-        logger.add("lookup_ns_per_query", tm.average() / queries.size());
-        logger.add("best_lookup_ns_per_query", tm.min() / queries.size());
+    if (!lookup_template(trie.get(), workloads[0], logger)) {
+        return;
     }
 
     if (run_decode) {
-        std::vector<uint64_t> ids(queries.size());
-        for (size_t i = 0; i < queries.size(); i++) {
-            ids[i] = lookup(trie.get(), queries[i]);
+        std::vector<uint64_t> ids;
+        for (const auto& query : workloads[0].queries) {
+            const uint64_t id = lookup(trie.get(), query);
+            if (id != NOT_FOUND) {
+                ids.push_back(id);
+            }
         }
 
+        perf_counters counters(PERF_COUNTERS);
         essentials::timer<essentials::clock_type, std::chrono::nanoseconds> tm;
         for (int i = 0; i <= SEARCH_RUNS; ++i) {
+            if (i == 1) {
+                counters.start();  // after warming up
+            }
             tm.start();
             for (const auto id : ids) {
                 if (decode(trie.get(), id) == 0) {
@@ -417,13 +1156,92 @@ void main_template(const char* title, std::vector<std::string>& keys, std::vecto
             }
             tm.stop();
         }
+        counters.stop();
         tm.discard_first();  // for warming up
         logger.add("decode_ns_per_query", tm.average() / ids.size());
         logger.add("best_decode_ns_per_query", tm.min() / ids.size());
+        counters.add_to(logger, "decode", "query", ids.size() * SEARCH_RUNS);
     }
 
     const uint64_t mem = get_memory(trie.get());
     logger.add("memory_in_bytes", mem);
+    if (get_memory_usage(trie.get()) != 0) {
+        logger.add("memory_usage_in_bytes", get_memory_usage(trie.get()));
+    }
+
+    // load TMP_INDEX_FILENAME written by get_memory from a cold and then a warm page cache
+    {
+        const auto& query = workloads[0].queries[0];
+        drop_page_cache(TMP_INDEX_FILENAME);
+
+        auto start = std::chrono::steady_clock::now();
+        auto loaded = load<T>(TMP_INDEX_FILENAME);
+        auto stop = std::chrono::steady_clock::now();
+        logger.add("cold_load_ns", std::chrono::duration_cast<std::chrono::nanoseconds>(stop - start).count());
+
+        start = std::chrono::steady_clock::now();
+        const uint64_t res = lookup(loaded.get(), query);
+        stop = std::chrono::steady_clock::now();
+        logger.add("first_query_ns", std::chrono::duration_cast<std::chrono::nanoseconds>(stop - start).count());
+        if (res != lookup(trie.get(), query)) {
+            tfm::errorfln("Loaded dictionary is inconsistent: %s", query);
+            return;
+        }
+
+        loaded.reset();
+        start = std::chrono::steady_clock::now();
+        loaded = load<T>(TMP_INDEX_FILENAME);
+        stop = std::chrono::steady_clock::now();
+        logger.add("warm_load_ns", std::chrono::duration_cast<std::chrono::nanoseconds>(stop - start).count());
+    }
+
+    for (size_t i = 1; i < workloads.size(); i++) {
+        logger.new_line();
+        logger.add("name", title);
+        if (!lookup_template(trie.get(), workloads[i], logger)) {
+            return;
+        }
+    }
+
+    for (const auto& w : workloads) {
+        if (w.cold) {
+            continue;
+        }
+        for (const uint32_t num_threads : NUM_READER_THREADS) {
+            concurrent_lookup_template(title, trie.get(), w, num_threads, logger);
+        }
+    }
+
+    const auto& queries = workloads[0].queries;
+    if (OPERATIONS.find("common_prefix") != std::string::npos) {
+        operation_template(title, "common_prefix", trie.get(), queries, logger,
+                           [](T* t, const std::string& query) { return common_prefix(t, query); });
+    }
+    if (OPERATIONS.find("predictive") != std::string::npos || OPERATIONS.find("count_prefix") != std::string::npos ||
+        OPERATIONS.find("top_k") != std::string::npos) {
+        // the queries are cut to prefixes, which have some keys below them
+        std::vector<std::string> prefixes(queries.size());
+        for (size_t i = 0; i < queries.size(); i++) {
+            const size_t length = size_t(std::ceil(queries[i].length() * PREDICTIVE_RATIO));
+            prefixes[i] = queries[i].substr(0, std::max<size_t>(length, 1));
+        }
+        if (OPERATIONS.find("predictive") != std::string::npos) {
+            operation_template(title, "predictive", trie.get(), prefixes, logger,
+                               [](T* t, const std::string& query) { return predictive(t, query); });
+        }
+        if (OPERATIONS.find("count_prefix") != std::string::npos) {
+            operation_template(title, "count_prefix", trie.get(), prefixes, logger,
+                               [](T* t, const std::string& query) { return count_prefix(t, query); });
+        }
+        if (OPERATIONS.find("top_k") != std::string::npos) {
+            operation_template(title, "top_k", trie.get(), prefixes, logger,
+                               [](T* t, const std::string& query) { return top_k(t, query, TOP_K); });
+        }
+    }
+    if (OPERATIONS.find("range_scan") != std::string::npos) {
+        operation_template(title, "range_scan", trie.get(), queries, logger,
+                           [](T* t, const std::string& query) { return range_scan(t, query, RANGE_LENGTH); });
+    }
 
     logger.print();
 }
@@ -434,6 +1252,44 @@ cmd_line_parser::parser make_parser(int argc, char** argv) {
     p.add("num_samples", "Number of sample keys for searches (default=100000)", "-n", false);
     p.add("random_seed", "Random seed for sampling (default=13)", "-s", false);
     p.add("to_unique", "Unique strings? (default=false)", "-u", false);
+    p.add("alloc_policy", "Allocation policy of FST arrays: 0=default, 1=THP, 2=hugetlbfs (default=0)", "-H", false);
+    p.add("pack_into_arena", "Pack FST arrays into a single arena? (default=false)", "-A", false);
+    p.add("bloom_bits_per_key", "Bits per key of the Bloom filter in front of FST, 0 for none (default=0)", "-b",
+          false);
+    p.add("fingerprint_bits", "Bits of the tail fingerprints of FST, 0 for none (default=0)", "-G", false);
+    p.add("inline_tail_bytes", "Tails of FST up to this many bytes (at most 3) are inlined, 0 for none (default=0)",
+          "-N", false);
+    p.add("rank_select", "Build FST with rank/select, needed by count_prefix? (default=false)", "-K", false);
+    p.add("bloom_miss_ratios",
+          "Comma-separated miss ratios to compare FST with and without Bloom filters on (default=none)", "-M", false);
+    p.add("bloom_sweep_bits", "Comma-separated Bloom filter bits per key compared by -M (default=0,6,10,14)", "-F",
+          false);
+    p.add("perf_counters", "Report hardware performance counters per key/query? (default=false)", "-P", false);
+    p.add("sweep", "Sweep the FST build parameters instead of the default build? (default=false)", "-S", false);
+    p.add("sweep_ratios",
+          "Comma-separated sparse_dense_ratio values to sweep, 0 for no dense levels (default=0,1,4,16,64,256)", "-R",
+          false);
+    p.add("sweep_rank_blocks", "Comma-separated rank block sizes to sweep (default=256,512,1024)", "-B", false);
+    p.add("sweep_select_intervals", "Comma-separated select sampling intervals to sweep (default=32,64,128)", "-I",
+          false);
+    p.add("operations",
+          "Comma-separated optional operations: common_prefix, predictive, range_scan, count_prefix, top_k "
+          "(default=none)",
+          "-O", false);
+    p.add("predictive_ratio", "Ratio of the query length kept as the prefix of predictive searches (default=0.75)",
+          "-x", false);
+    p.add("range_length", "Number of keys visited by a range scan (default=100)", "-L", false);
+    p.add("top_k", "Number of completions of a top-k query (default=10)", "-k", false);
+    p.add("traversal_stats", "Dump FST traversal counters of the queries? (default=false)", "-T", false);
+    p.add("reader_threads", "Comma-separated numbers of concurrent reader threads, e.g., 1,8,32 (default=none)", "-t",
+          false);
+    p.add("workloads", "Comma-separated query workloads: uniform, zipf, sorted, miss, cold (default=uniform)", "-w",
+          false);
+    p.add("miss_ratio", "Ratio of non-key queries in the miss workload (default=0.5)", "-m", false);
+    p.add("zipf_skew", "Skew of the zipf workload (default=0.99)", "-z", false);
+    p.add("cold_samples", "Number of queries of the cold workload (default=1000)", "-c", false);
+    p.add("eviction_mib", "Size of the buffer read to evict the caches, larger than the LLC (default=64)", "-e",
+          false);
     return p;
 }
 
@@ -452,54 +1308,141 @@ int main(int argc, char* argv[]) {
     const auto num_samples = p.get<std::uint64_t>("num_samples", 100000);
     const auto random_seed = p.get<std::uint64_t>("random_seed", 13);
     const auto to_unique = p.get<bool>("to_unique", false);
+    for (const auto& token : split_list(p.get<std::string>("reader_threads", ""))) {
+        NUM_READER_THREADS.push_back(uint32_t(std::stoul(token)));
+    }
+    EVICTION_BYTES = p.get<std::uint64_t>("eviction_mib", 64) << 20;
+    PERF_COUNTERS = p.get<bool>("perf_counters", false);
+    OPERATIONS = p.get<std::string>("operations", "");
+    PREDICTIVE_RATIO = p.get<double>("predictive_ratio", 0.75);
+    RANGE_LENGTH = p.get<std::uint64_t>("range_length", 100);
+    TOP_K = p.get<std::uint64_t>("top_k", 10);
+    if (PERF_COUNTERS && !perf_counters(true).available()) {
+        tfm::warnfln("Hardware performance counters are unavailable, so they are not reported.");
+        PERF_COUNTERS = false;
+    }
+
+    workload_options opts;
+    opts.num_samples = num_samples;
+    opts.random_seed = random_seed;
+    opts.miss_ratio = p.get<double>("miss_ratio", 0.5);
+    opts.zipf_skew = p.get<double>("zipf_skew", 0.99);
+    opts.cold_samples = p.get<std::uint64_t>("cold_samples", 1000);
 
     auto keys = load_strings(input_keys, to_unique);
-    auto queries = sample_strings(keys, num_samples, random_seed);
+
+    std::vector<workload> workloads;
+    for (const auto& name : split_list(p.get<std::string>("workloads", "uniform"))) {
+        workloads.push_back(make_workload(name, keys, opts));
+        if (workloads.back().name.empty()) {
+            tfm::errorfln("Unknown workload: %s", name);
+            return 1;
+        }
+    }
 
 #ifdef USE_FST
-    main_template<trie_t>("FST", keys, queries, false);
+    const auto alloc_policy = p.get<int>("alloc_policy", 0);
+    const auto pack_into_arena = p.get<bool>("pack_into_arena", false);
+    surf::setAllocPolicy(static_cast<surf::AllocPolicy>(alloc_policy));
+    PACK_INTO_ARENA = pack_into_arena;
+    BLOOM_BITS_PER_KEY = p.get<uint32_t>("bloom_bits_per_key", 0);
+    FINGERPRINT_BITS = p.get<uint32_t>("fingerprint_bits", 0);
+    INLINE_TAIL_BYTES = p.get<uint32_t>("inline_tail_bytes", 0);
+    RANK_SELECT = p.get<bool>("rank_select", false);
+    {
+        std::string name = alloc_policy == 0 ? "FST" : tfm::format("FST_H%d", alloc_policy);
+        if (pack_into_arena) {
+            name += "_A";
+        }
+        if (BLOOM_BITS_PER_KEY != 0) {
+            name += tfm::format("_BF%d", BLOOM_BITS_PER_KEY);
+        }
+        if (FINGERPRINT_BITS != 0) {
+            name += tfm::format("_FP%d", FINGERPRINT_BITS);
+        }
+        if (INLINE_TAIL_BYTES != 0) {
+            name += tfm::format("_IT%d", INLINE_TAIL_BYTES);
+        }
+        if (RANK_SELECT) {
+            name += "_RS";
+        }
+        if (p.get<bool>("sweep", false)) {
+            auto to_values = [](const std::string& list) {
+                std::vector<uint32_t> values;
+                for (const auto& token : split_list(list)) {
+                    values.push_back(uint32_t(std::stoul(token)));
+                }
+                return values;
+            };
+            const auto rank_blocks = to_values(p.get<std::string>("sweep_rank_blocks", "256,512,1024"));
+            for (const uint32_t size : rank_blocks) {
+                if (size < 64 || (size & (size - 1)) != 0) {
+                    tfm::errorfln("Rank block sizes must be powers of two and at least 64: %d", size);
+                    return 1;
+                }
+            }
+            sweep_configs(keys, workloads[0], to_values(p.get<std::string>("sweep_ratios", "0,1,4,16,64,256")),
+                          rank_blocks, to_values(p.get<std::string>("sweep_select_intervals", "32,64,128")));
+        } else {
+            main_template<trie_t>(name.c_str(), keys, workloads, false);
+        }
+    }
+    if (p.get<bool>("traversal_stats", false)) {
+        dump_traversal_stats(keys, workloads[0].queries);
+    }
+    if (p.parsed("bloom_miss_ratios")) {
+        std::vector<double> miss_ratios;
+        for (const auto& token : split_list(p.get<std::string>("bloom_miss_ratios"))) {
+            miss_ratios.push_back(std::stod(token));
+        }
+        std::vector<uint32_t> bloom_bits;
+        for (const auto& token : split_list(p.get<std::string>("bloom_sweep_bits", "0,6,10,14"))) {
+            bloom_bits.push_back(uint32_t(std::stoul(token)));
+        }
+        sweep_bloom(keys, opts, miss_ratios, bloom_bits);
+    }
 #endif
 #ifdef USE_DARTS
-    main_template<trie_t>("DARTS", keys, queries, false);
+    main_template<trie_t>("DARTS", keys, workloads, false);
 #endif
 #ifdef USE_DARTSC
-    main_template<trie_t>("DARTSC", keys, queries, false);
+    main_template<trie_t>("DARTSC", keys, workloads, false);
 #endif
 #ifdef USE_CEDAR
-    main_template<trie_t>("CEDAR", keys, queries, false);
+    main_template<trie_t>("CEDAR", keys, workloads, false);
 #endif
 #ifdef USE_CEDARPP
-    main_template<trie_t>("CEDARPP", keys, queries, false);
+    main_template<trie_t>("CEDARPP", keys, workloads, false);
 #endif
 #ifdef USE_DASTRIE
-    main_template<trie_t>("DASTRIE", keys, queries, false);
+    main_template<trie_t>("DASTRIE", keys, workloads, false);
 #endif
 #ifdef USE_TX
-    main_template<trie_t>("TX", keys, queries, true);
+    main_template<trie_t>("TX", keys, workloads, true);
 #endif
 #ifdef USE_MARISA
-    main_template<trie_t>("MARISA", keys, queries, true);
+    main_template<trie_t>("MARISA", keys, workloads, true);
 #endif
 #ifdef USE_XCDAT_7
-    main_template<trie_t>("XCDAT_7", keys, queries, true);
+    main_template<trie_t>("XCDAT_7", keys, workloads, true);
 #endif
 #ifdef USE_XCDAT_8
-    main_template<trie_t>("XCDAT_8", keys, queries, true);
+    main_template<trie_t>("XCDAT_8", keys, workloads, true);
 #endif
 #ifdef USE_XCDAT_15
-    main_template<trie_t>("XCDAT_15", keys, queries, true);
+    main_template<trie_t>("XCDAT_15", keys, workloads, true);
 #endif
 #ifdef USE_XCDAT_16
-    main_template<trie_t>("XCDAT_16", keys, queries, true);
+    main_template<trie_t>("XCDAT_16", keys, workloads, true);
 #endif
 #ifdef USE_PDT
-    main_template<trie_t>("PDT", keys, queries, true);
+    main_template<trie_t>("PDT", keys, workloads, true);
 #endif
 #ifdef USE_HATTRIE
-    main_template<trie_t>("HATTRIE", keys, queries, false);
+    main_template<trie_t>("HATTRIE", keys, workloads, false);
 #endif
 #ifdef USE_ARRAYHASH
-    main_template<trie_t>("ARRAYHASH", keys, queries, false);
+    main_template<trie_t>("ARRAYHASH", keys, workloads, false);
 #endif
     std::remove(TMP_INDEX_FILENAME);
 
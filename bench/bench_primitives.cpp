@@ -0,0 +1,238 @@
+#include <algorithm>
+#include <numeric>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <fst.hpp>
+
+#include "cmd_line_parser/parser.hpp"
+#include "essentials/essentials.hpp"
+#include "tinyformat/tinyformat.h"
+
+// Microbenchmark of the succinct primitives on synthetic inputs of controlled size and density.
+// Every operation takes the previous result as an input, so the numbers are latencies of
+// dependent operations (as in a trie walk) rather than throughputs.
+
+static int NUM_RUNS = 5;
+static uint64_t NUM_OPS = 1000000;
+static volatile uint64_t SINK = 0;
+
+using surf::kMsbMask;
+using surf::kWordSize;
+using surf::label_t;
+using surf::position_t;
+using surf::word_t;
+
+std::vector<uint64_t> parse_list(const std::string& str) {
+    std::vector<uint64_t> values;
+    std::istringstream iss(str);
+    for (std::string token; std::getline(iss, token, ',');) {
+        values.push_back(std::stoull(token));
+    }
+    return values;
+}
+
+std::vector<double> parse_real_list(const std::string& str) {
+    std::vector<double> values;
+    std::istringstream iss(str);
+    for (std::string token; std::getline(iss, token, ',');) {
+        values.push_back(std::stod(token));
+    }
+    return values;
+}
+
+// Runs op over the inputs NUM_RUNS + 1 times, discarding the first run for warming up.
+template <class Op>
+void run_template(const std::vector<uint32_t>& inputs, essentials::json_lines& logger, Op op) {
+    essentials::timer<essentials::clock_type, std::chrono::nanoseconds> tm;
+    uint64_t prev = 0;
+    for (int r = 0; r <= NUM_RUNS; r++) {
+        tm.start();
+        for (const uint32_t input : inputs) {
+            prev = op(input, prev);
+        }
+        tm.stop();
+    }
+    tm.discard_first();
+    SINK = SINK + prev;
+    logger.add("ns_per_op", tm.average() / inputs.size());
+    logger.add("best_ns_per_op", tm.min() / inputs.size());
+}
+
+std::vector<uint32_t> random_inputs(uint64_t min, uint64_t max, std::mt19937_64& engine) {
+    std::uniform_int_distribution<uint64_t> dist(min, max);
+    std::vector<uint32_t> inputs(NUM_OPS);
+    for (auto& input : inputs) {
+        input = uint32_t(dist(engine));
+    }
+    return inputs;
+}
+
+// Bits are set independently with the given probability; the last bit is always set
+// because distanceToNextSetBit expects a set bit ahead.
+std::vector<word_t> random_bits(uint64_t num_bits, double density, std::mt19937_64& engine) {
+    std::vector<word_t> words((num_bits + kWordSize - 1) / kWordSize, 0);
+    std::bernoulli_distribution dist(density);
+    for (uint64_t i = 0; i < num_bits; i++) {
+        if (dist(engine)) {
+            words[i / kWordSize] |= kMsbMask >> (i % kWordSize);
+        }
+    }
+    words[(num_bits - 1) / kWordSize] |= kMsbMask >> ((num_bits - 1) % kWordSize);
+    return words;
+}
+
+void bench_bitvectors(uint64_t log2_bits, double density, std::mt19937_64& engine) {
+    const position_t num_bits = position_t((uint64_t(1) << log2_bits) - 1);
+    const std::vector<std::vector<word_t>> bits_per_level = {random_bits(num_bits, density, engine)};
+    const std::vector<position_t> num_bits_per_level = {num_bits};
+
+    auto make_logger = [&](const char* primitive) {
+        essentials::json_lines logger;
+        logger.add("primitive", primitive);
+        logger.add("log2_bits", log2_bits);
+        logger.add("density", density);
+        return logger;
+    };
+
+    {
+        surf::BitvectorRank bv(512, bits_per_level, num_bits_per_level);
+        auto logger = make_logger("rank");
+        run_template(random_inputs(0, num_bits - 2, engine), logger,
+                     [&](uint32_t pos, uint64_t prev) { return bv.rank(pos + (prev & 1)); });
+        logger.print();
+
+        logger = make_logger("distanceToNextSetBit");
+        run_template(random_inputs(0, num_bits - 2, engine), logger,
+                     [&](uint32_t pos, uint64_t prev) { return bv.distanceToNextSetBit(pos + (prev & 1)); });
+        logger.print();
+    }
+    {
+        surf::BitvectorSelect bv(64, bits_per_level, num_bits_per_level);
+        auto logger = make_logger("select");
+        run_template(random_inputs(1, bv.numOnes() - 1, engine), logger,
+                     [&](uint32_t rank, uint64_t prev) { return bv.select(rank + (prev & 1)); });
+        logger.print();
+    }
+}
+
+void bench_labels(uint64_t log2_bits, uint64_t fanout, std::mt19937_64& engine) {
+    const uint64_t num_nodes = std::max<uint64_t>((uint64_t(1) << log2_bits) / 8 / fanout, 1);
+
+    // each node has fanout distinct sorted labels (no terminator)
+    std::vector<std::vector<label_t>> labels_per_level(1);
+    std::vector<label_t> alphabet(255);
+    std::iota(alphabet.begin(), alphabet.end(), label_t(1));
+    for (uint64_t i = 0; i < num_nodes; i++) {
+        std::shuffle(alphabet.begin(), alphabet.end(), engine);
+        std::sort(alphabet.begin(), alphabet.begin() + fanout);
+        labels_per_level[0].insert(labels_per_level[0].end(), alphabet.begin(), alphabet.begin() + fanout);
+    }
+    const surf::LabelVector labels(labels_per_level);
+
+    // a query is a label position; the search looks for that label in its node
+    const auto inputs = random_inputs(0, num_nodes * fanout - 2, engine);
+    const position_t n = position_t(fanout);
+
+    auto bench_kernel = [&](const char* primitive, auto search) {
+        essentials::json_lines logger;
+        logger.add("primitive", primitive);
+        logger.add("log2_bits", log2_bits);
+        logger.add("fanout", fanout);
+        run_template(inputs, logger, [&](uint32_t pos, uint64_t prev) {
+            const position_t label_pos = position_t(pos + prev);  // prev is 0 unless the search failed
+            position_t node_pos = label_pos - label_pos % n;
+            const bool found = search(labels[label_pos], node_pos);
+            return uint64_t(!found || node_pos != label_pos);
+        });
+        logger.print();
+    };
+    bench_kernel("LabelVector::search", [&](label_t target, position_t& pos) { return labels.search(target, pos, n); });
+    bench_kernel("LabelVector::linearSearch",
+                 [&](label_t target, position_t& pos) { return labels.linearSearch(target, pos, n); });
+    bench_kernel("LabelVector::binarySearch",
+                 [&](label_t target, position_t& pos) { return labels.binarySearch(target, pos, n); });
+    bench_kernel("LabelVector::simdSearch",
+                 [&](label_t target, position_t& pos) { return labels.simdSearch(target, pos, n); });
+}
+
+void bench_compact_array(uint64_t log2_bits, uint32_t width, std::mt19937_64& engine) {
+    const uint64_t size = std::max<uint64_t>((uint64_t(1) << log2_bits) / width, 2);
+    std::uniform_int_distribution<uint32_t> dist(0, (1U << width) - 1);
+    std::vector<uint32_t> values(size);
+    for (auto& v : values) {
+        v = dist(engine);
+    }
+    const fst::detail::CompactArray array(values, width);
+
+    essentials::json_lines logger;
+    logger.add("primitive", "CompactArray::operator[]");
+    logger.add("log2_bits", log2_bits);
+    logger.add("width", width);
+    run_template(random_inputs(0, size - 2, engine), logger,
+                 [&](uint32_t i, uint64_t prev) { return array[uint32_t(i + (prev & 1))]; });
+    logger.print();
+}
+
+cmd_line_parser::parser make_parser(int argc, char** argv) {
+    cmd_line_parser::parser p(argc, argv);
+    p.add("log2_bits", "Comma-separated log2 of the input sizes in bits (default=16,20,24,28,31)", "-b", false);
+    p.add("densities", "Comma-separated ratios of 1 bits (default=0.01,0.1,0.5,0.9)", "-d", false);
+    p.add("fanouts", "Comma-separated node sizes for label searches (default=2,4,8,16,32,64,128,255)", "-f", false);
+    p.add("width", "Bits per CompactArray entry, in [1,31] (default=20)", "-w", false);
+    p.add("num_ops", "Number of operations per run (default=1000000)", "-n", false);
+    p.add("num_runs", "Number of runs after warming up (default=5)", "-r", false);
+    p.add("random_seed", "Random seed (default=13)", "-s", false);
+    p.add("primitives", "Comma-separated subset of bitvector, label, compact (default=all)", "-p", false);
+    return p;
+}
+
+int main(int argc, char* argv[]) {
+#ifndef NDEBUG
+    tfm::warnfln("The code is running in debug mode.");
+#endif
+    std::ios::sync_with_stdio(false);
+
+    auto p = make_parser(argc, argv);
+    if (!p.parse()) {
+        return 1;
+    }
+
+    const auto log2_bits_list = parse_list(p.get<std::string>("log2_bits", "16,20,24,28,31"));
+    const auto densities = parse_real_list(p.get<std::string>("densities", "0.01,0.1,0.5,0.9"));
+    const auto fanouts = parse_list(p.get<std::string>("fanouts", "2,4,8,16,32,64,128,255"));
+    const auto width = p.get<uint32_t>("width", 20);
+    const auto primitives = p.get<std::string>("primitives", "bitvector,label,compact");
+    NUM_OPS = p.get<uint64_t>("num_ops", 1000000);
+    NUM_RUNS = p.get<int>("num_runs", 5);
+
+    if (width < 1 || width > 31) {
+        tfm::errorfln("width must be in [1,31]");
+        return 1;
+    }
+
+    std::mt19937_64 engine(p.get<uint64_t>("random_seed", 13));
+
+    for (const uint64_t log2_bits : log2_bits_list) {
+        if (log2_bits > 32) {
+            tfm::errorfln("log2_bits must be at most 32");
+            return 1;
+        }
+        if (primitives.find("bitvector") != std::string::npos) {
+            for (const double density : densities) {
+                bench_bitvectors(log2_bits, density, engine);
+            }
+        }
+        if (primitives.find("label") != std::string::npos) {
+            for (const uint64_t fanout : fanouts) {
+                bench_labels(log2_bits, std::min<uint64_t>(fanout, 255), engine);
+            }
+        }
+        if (primitives.find("compact") != std::string::npos) {
+            bench_compact_array(log2_bits, width, engine);
+        }
+    }
+    return 0;
+}
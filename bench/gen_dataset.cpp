@@ -0,0 +1,256 @@
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <queue>
+#include <string>
+#include <vector>
+
+#include "cmd_line_parser/parser.hpp"
+#include "tinyformat/tinyformat.h"
+#include "workload.hpp"
+
+// Generator of synthetic key sets shaped like common real-world keys. The output is sorted and
+// unique, one key per line, and the same for the same arguments. Keys are produced in chunks that
+// are sorted in memory and merged through temporary files, so billions of keys need only the
+// memory of one chunk.
+//
+//  - url:    URLs whose hosts and path segments are Zipf-distributed (long shared prefixes)
+//  - uuid:   random version-4 UUIDs (no shared structure beyond the first bytes)
+//  - int64:  clustered 64-bit integers as 16 big-endian hex digits (fixed width, so the byte
+//            order is the numeric order as with binary big-endian keys)
+//  - ipv4:   IPv4 addresses concentrated in a few subnets
+//  - domain: reversed domain names (com.example.www), as used for row keys
+//  - path:   file paths of a synthetic directory tree
+
+class key_generator {
+  public:
+    key_generator(const std::string& type, uint64_t num_keys, uint64_t random_seed)
+        : m_type(type)
+        , m_num_keys(num_keys)
+        , m_engine(random_seed)
+        // the vocabulary grows with the key set, so that large key sets are not all duplicates
+        , m_words(make_vocabulary(std::clamp<uint64_t>(num_keys / 16, 1024, 1 << 20)))
+        , m_word_dist(m_words.size(), 0.9)
+        , m_host_dist(std::max<uint64_t>(num_keys / 1000, 16), 1.0)
+        , m_subnet_dist(std::max<uint64_t>(num_keys / 4096, 64), 1.2)
+        , m_next_int(m_engine() >> 16) {}
+
+    bool is_valid() const {
+        return m_type == "url" || m_type == "uuid" || m_type == "int64" || m_type == "ipv4" || m_type == "domain" ||
+               m_type == "path";
+    }
+
+    std::string operator()() {
+        if (m_type == "url") return next_url();
+        if (m_type == "uuid") return next_uuid();
+        if (m_type == "int64") return next_int64();
+        if (m_type == "ipv4") return next_ipv4();
+        if (m_type == "domain") return next_domain();
+        return next_path();
+    }
+
+  private:
+    std::string m_type;
+    uint64_t m_num_keys;
+    std::mt19937_64 m_engine;
+    std::vector<std::string> m_words;
+    zipf_distribution m_word_dist;
+    zipf_distribution m_host_dist;
+    zipf_distribution m_subnet_dist;
+    uint64_t m_next_int;
+
+    static constexpr const char* TLDS[] = {"com", "org", "net", "de", "jp", "uk", "io", "fr", "ru", "br", "edu", "gov"};
+    static constexpr const char* SUBDOMAINS[] = {"www", "mail", "api", "cdn", "static", "blog", "shop", "m"};
+    static constexpr const char* EXTENSIONS[] = {".txt", ".log", ".cpp", ".hpp", ".json", ".png", ".so", ".conf"};
+    static constexpr const char* ROOTS[] = {"/usr/lib", "/usr/share", "/home", "/var/log", "/opt", "/srv/data"};
+
+    uint64_t uniform(uint64_t n) {
+        return m_engine() % n;
+    }
+    bool coin(double p) {
+        return (m_engine() >> 11) * 0x1.0p-53 < p;
+    }
+    template <class T, size_t N>
+    const char* pick(const T (&items)[N]) {
+        // skewed towards the first items
+        return items[std::min<uint64_t>(uniform(N), uniform(N))];
+    }
+    const std::string& word() {
+        return m_words[m_word_dist(m_engine) - 1];
+    }
+
+    // Pronounceable words of one to four syllables
+    std::vector<std::string> make_vocabulary(uint64_t size) {
+        static const char* consonants = "bcdfghjklmnprstvwz";
+        static const char* vowels = "aeiou";
+        std::vector<std::string> words(size);
+        for (auto& w : words) {
+            const uint64_t num_syllables = 1 + uniform(4);
+            for (uint64_t i = 0; i < num_syllables; i++) {
+                w.push_back(consonants[uniform(18)]);
+                w.push_back(vowels[uniform(5)]);
+                if (coin(0.3)) w.push_back(consonants[uniform(18)]);
+            }
+        }
+        return words;
+    }
+
+    std::string host(uint64_t rank) {
+        // hosts are a function of their rank, so popular hosts recur with the same name
+        std::mt19937_64 engine(rank * 0x9E3779B97F4A7C15ULL);
+        std::string h = m_words[engine() % m_words.size()];
+        if (engine() % 4 == 0) h += "-" + m_words[engine() % m_words.size()];
+        return h + "." + TLDS[engine() % std::size(TLDS)];
+    }
+
+    std::string next_url() {
+        const uint64_t rank = m_host_dist(m_engine);
+        std::string url = coin(0.9) ? "https://" : "http://";
+        if (rank % 3 != 0) url += "www.";
+        url += host(rank);
+        const uint64_t depth = 1 + uniform(4);
+        for (uint64_t i = 0; i < depth; i++) {
+            url += "/" + word();
+        }
+        if (coin(0.4)) {
+            url += tfm::format("?id=%d", uniform(m_num_keys * 16));
+        } else if (coin(0.5)) {
+            url += ".html";
+        }
+        return url;
+    }
+
+    std::string next_uuid() {
+        const uint64_t hi = (m_engine() & 0xFFFFFFFFFFFF0FFFULL) | 0x4000ULL;
+        const uint64_t lo = (m_engine() & 0x3FFFFFFFFFFFFFFFULL) | 0x8000000000000000ULL;
+        return tfm::format("%08x-%04x-%04x-%04x-%012x", hi >> 32, (hi >> 16) & 0xFFFF, hi & 0xFFFF, lo >> 48,
+                           lo & 0xFFFFFFFFFFFFULL);
+    }
+
+    std::string next_int64() {
+        // mostly small gaps (as in auto-increment IDs or timestamps) with rare large jumps
+        m_next_int += coin(0.001) ? uniform(uint64_t(1) << 40) : 1 + uniform(8);
+        return tfm::format("%016x", m_next_int);
+    }
+
+    std::string next_ipv4() {
+        const uint64_t subnet = m_subnet_dist(m_engine) * 0x9E3779B97F4A7C15ULL >> 48;  // a /16
+        return tfm::format("%d.%d.%d.%d", subnet >> 8, subnet & 0xFF, uniform(256), uniform(256));
+    }
+
+    std::string next_domain() {
+        std::string domain = pick(TLDS);
+        domain += "." + word();
+        if (coin(0.3)) domain += "-" + word();
+        const uint64_t depth = uniform(3);
+        for (uint64_t i = 0; i < depth; i++) {
+            domain += ".";
+            domain += coin(0.5) ? pick(SUBDOMAINS) : word();
+        }
+        return domain;
+    }
+
+    std::string next_path() {
+        std::string path = pick(ROOTS);
+        const uint64_t depth = 1 + uniform(6);
+        for (uint64_t i = 0; i < depth; i++) {
+            path += "/" + word();
+        }
+        if (coin(0.5)) path += tfm::format("_%d", uniform(m_num_keys));
+        return path + pick(EXTENSIONS);
+    }
+};
+
+// Writes the sorted unique keys of a chunk
+void write_chunk(std::vector<std::string>& keys, const std::string& filepath) {
+    std::sort(keys.begin(), keys.end());
+    keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+    std::ofstream ofs(filepath);
+    for (const auto& key : keys) {
+        ofs << key << '\n';
+    }
+}
+
+// Merges the sorted chunk files into output_path removing duplicates, and returns the number of keys.
+uint64_t merge_chunks(const std::vector<std::string>& chunk_paths, const std::string& output_path) {
+    using entry_type = std::pair<std::string, size_t>;
+    std::vector<std::ifstream> inputs;
+    std::priority_queue<entry_type, std::vector<entry_type>, std::greater<entry_type>> heap;
+    for (size_t i = 0; i < chunk_paths.size(); i++) {
+        inputs.emplace_back(chunk_paths[i]);
+        std::string key;
+        if (std::getline(inputs[i], key)) heap.emplace(std::move(key), i);
+    }
+
+    std::ofstream ofs(output_path);
+    std::string last;
+    uint64_t num_keys = 0;
+    while (!heap.empty()) {
+        auto [key, i] = heap.top();
+        heap.pop();
+        if (num_keys == 0 || key != last) {
+            ofs << key << '\n';
+            last = key;
+            num_keys += 1;
+        }
+        if (std::getline(inputs[i], key)) heap.emplace(std::move(key), i);
+    }
+    return num_keys;
+}
+
+cmd_line_parser::parser make_parser(int argc, char** argv) {
+    cmd_line_parser::parser p(argc, argv);
+    p.add("type", "Key type: url, uuid, int64, ipv4, domain or path");
+    p.add("num_keys", "Number of keys to generate; duplicates are removed, so the output may be a bit smaller");
+    p.add("output_path", "Output filepath");
+    p.add("random_seed", "Random seed (default=13)", "-s", false);
+    p.add("chunk_size", "Number of keys sorted in memory at once (default=10000000)", "-c", false);
+    return p;
+}
+
+int main(int argc, char* argv[]) {
+    std::ios::sync_with_stdio(false);
+
+    auto p = make_parser(argc, argv);
+    if (!p.parse()) {
+        return 1;
+    }
+
+    const auto type = p.get<std::string>("type");
+    const auto num_keys = p.get<uint64_t>("num_keys");
+    const auto output_path = p.get<std::string>("output_path");
+    const auto chunk_size = std::max<uint64_t>(p.get<uint64_t>("chunk_size", 10000000), 1);
+
+    key_generator gen(type, num_keys, p.get<uint64_t>("random_seed", 13));
+    if (!gen.is_valid()) {
+        tfm::errorfln("Unknown key type: %s", type);
+        return 1;
+    }
+
+    std::vector<std::string> chunk_paths;
+    std::vector<std::string> keys;
+    for (uint64_t i = 0; i < num_keys;) {
+        const uint64_t size = std::min(chunk_size, num_keys - i);
+        keys.resize(size);
+        for (auto& key : keys) {
+            key = gen();
+        }
+        i += size;
+        if (chunk_paths.empty() && i == num_keys) {
+            write_chunk(keys, output_path);  // fits in one chunk
+            tfm::printfln("Wrote %d keys to %s", keys.size(), output_path);
+            return 0;
+        }
+        chunk_paths.push_back(tfm::format("%s.chunk%d", output_path, chunk_paths.size()));
+        write_chunk(keys, chunk_paths.back());
+        tfm::printfln("Wrote chunk %d (%d/%d keys)", chunk_paths.size() - 1, i, num_keys);
+    }
+    keys = std::vector<std::string>();
+
+    const uint64_t num_unique = merge_chunks(chunk_paths, output_path);
+    for (const auto& path : chunk_paths) {
+        std::remove(path.c_str());
+    }
+    tfm::printfln("Wrote %d keys to %s", num_unique, output_path);
+    return 0;
+}
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// Hardware performance counters of the calling thread through perf_event_open(2).
+// The events are opened one by one rather than as a group, so that an unsupported event
+// (common in VMs) does not disable the others; counts are scaled for multiplexing.
+// Events that cannot be opened (no PMU, perf_event_paranoid, seccomp) are omitted,
+// and with none of them the counters are unavailable and report nothing.
+class perf_counters {
+  public:
+    // If not enabled, no event is opened and all the operations are no-ops.
+    explicit perf_counters(bool enabled) {
+        if (!enabled) {
+            return;
+        }
+        static const uint64_t L1D_READ_MISS = PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                                              (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+        static const uint64_t LL_READ_MISS = PERF_COUNT_HW_CACHE_LL | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                                             (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+        static const uint64_t DTLB_READ_MISS = PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                                               (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+        open_event("instructions", PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+        open_event("cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES);
+        open_event("branch_misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES);
+        open_event("l1d_misses", PERF_TYPE_HW_CACHE, L1D_READ_MISS);
+        open_event("llc_misses", PERF_TYPE_HW_CACHE, LL_READ_MISS);
+        open_event("dtlb_misses", PERF_TYPE_HW_CACHE, DTLB_READ_MISS);
+    }
+    ~perf_counters() {
+        for (const auto& e : m_events) {
+            close(e.fd);
+        }
+    }
+
+    perf_counters(const perf_counters&) = delete;
+    perf_counters& operator=(const perf_counters&) = delete;
+
+    bool available() const {
+        return !m_events.empty();
+    }
+
+    // Resets and enables the counters.
+    void start() {
+        for (const auto& e : m_events) {
+            ioctl(e.fd, PERF_EVENT_IOC_RESET, 0);
+        }
+        resume();
+    }
+    // Disables the counters without resetting them, to exclude a region from the counts.
+    void pause() {
+        for (const auto& e : m_events) {
+            ioctl(e.fd, PERF_EVENT_IOC_DISABLE, 0);
+        }
+    }
+    void resume() {
+        for (const auto& e : m_events) {
+            ioctl(e.fd, PERF_EVENT_IOC_ENABLE, 0);
+        }
+    }
+    // Disables the counters and reads the counts.
+    void stop() {
+        pause();
+        for (auto& e : m_events) {
+            uint64_t values[3] = {};  // value, time enabled, time running
+            if (read(e.fd, values, sizeof(values)) != sizeof(values) || values[2] == 0) {
+                e.count = 0.0;
+            } else {
+                e.count = double(values[0]) * values[1] / values[2];
+            }
+        }
+    }
+
+    // Adds "<prefix>_<event>_per_<unit>" of the last counts divided by n.
+    template <class Logger>
+    void add_to(Logger& logger, const char* prefix, const char* unit, uint64_t n) const {
+        for (const auto& e : m_events) {
+            logger.add(std::string(prefix) + "_" + e.name + "_per_" + unit, e.count / n);
+        }
+    }
+
+  private:
+    struct event {
+        const char* name;
+        int fd;
+        double count;
+    };
+    std::vector<event> m_events;
+
+    void open_event(const char* name, uint32_t type, uint64_t config) {
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = type;
+        attr.config = config;
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        const int fd = int(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+        if (fd >= 0) {
+            m_events.push_back({name, fd, 0.0});
+        }
+    }
+};
@@ -27,20 +27,27 @@ PROPS = {
 }
 
 
-def load_logs(input_path):
+# Loads the first line of each library, of the dataset if given.
+def load_logs(input_path, dataset=None):
     logs_dict = {}
     for json_str in open(input_path, 'rt'):
+        if not json_str.startswith('{'):
+            continue
         obj = json.loads(json_str)
-        logs_dict[obj['name']] = obj
+        if dataset is not None and obj.get('dataset') != dataset:
+            continue
+        if 'memory_in_bytes' in obj:
+            logs_dict[obj['name']] = obj
     return logs_dict
 
 
 def main():
     parser = ArgumentParser()
     parser.add_argument('input_path')
+    parser.add_argument('--dataset', help='dataset name tagged by run_bench.py')
     args = parser.parse_args()
 
-    logs_dict = load_logs(args.input_path)
+    logs_dict = load_logs(args.input_path, args.dataset)
 
     for name, prop in PROPS.items():
         if not name in logs_dict:
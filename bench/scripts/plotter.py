@@ -31,11 +31,17 @@ PROPS = {
 }
 
 
-def load_logs(input_path):
+# Loads the first line of each library, of the dataset if given.
+def load_logs(input_path, dataset=None):
     logs_dict = {}
     for json_str in open(input_path, 'rt'):
+        if not json_str.startswith('{'):
+            continue
         obj = json.loads(json_str)
-        logs_dict[obj['name']] = obj
+        if dataset is not None and obj.get('dataset') != dataset:
+            continue
+        if 'memory_in_bytes' in obj:
+            logs_dict[obj['name']] = obj
     return logs_dict
 
 
@@ -121,17 +127,60 @@ def plot_decode_vs_memory(logs_dict, title):
     plt.close(fig)
 
 
+# Loads the lines of bench_fst -S, of the dataset if given.
+def load_sweep_logs(input_path, dataset=None):
+    logs = []
+    for json_str in open(input_path, 'rt'):
+        if not json_str.startswith('{'):
+            continue
+        obj = json.loads(json_str)
+        if dataset is not None and obj.get('dataset') != dataset:
+            continue
+        if obj['name'] == 'FST_SWEEP':
+            logs.append(obj)
+    return logs
+
+
+def plot_sweep_pareto(logs, title):
+    fig, ax = plt.subplots()
+    frontier = []
+    for log_dict in logs:
+        x = int(log_dict['memory_in_bytes']) / MiB
+        y = float(log_dict['best_lookup_ns_per_query'])
+        ax.plot(x, y, marker='o', ls='None', color=CNAMES['darkgrey'], mfc='None')
+        if log_dict['pareto_optimal'] == 'true':
+            frontier.append((x, y, log_dict))
+    frontier.sort(key=lambda p: p[0])
+    ax.plot([p[0] for p in frontier], [p[1] for p in frontier], marker='o', color=CNAMES['red'], label='Pareto frontier')
+    for x, y, log_dict in frontier:
+        ratio = log_dict['sparse_dense_ratio'] if log_dict['include_dense'] == 'true' else '-'
+        label = f"{ratio}/{log_dict['rank_block_size']}/{log_dict['select_sample_interval']}"
+        ax.annotate(label, (x, y), textcoords='offset points', xytext=(4, 4), fontsize=7)
+    ax.legend(loc='upper right')
+    ax.set_xlabel('Memory usage (MiB)')
+    ax.set_ylabel('Lookup time (ns/key)')
+    ax.set_title(f'{title} (sparse_dense_ratio/rank_block_size/select_sample_interval)', fontsize=9)
+    fig.tight_layout()
+    fig.savefig('sweep_pareto.png')
+    plt.close(fig)
+
+
 def main():
     parser = ArgumentParser()
     parser.add_argument('input_path')
     parser.add_argument('title')
+    parser.add_argument('--dataset', help='dataset name tagged by run_bench.py')
     args = parser.parse_args()
 
-    logs_dict = load_logs(args.input_path)
+    logs_dict = load_logs(args.input_path, args.dataset)
     plot_lookup_vs_memory(logs_dict, args.title)
     plot_decode_vs_memory(logs_dict, args.title)
     plot_constr_vs_memory(logs_dict, args.title)
 
+    sweep_logs = load_sweep_logs(args.input_path, args.dataset)
+    if sweep_logs:
+        plot_sweep_pareto(sweep_logs, args.title)
+
 
 if __name__ == "__main__":
     main()
@@ -2,6 +2,7 @@
 
 import os
 import re
+import json
 import subprocess
 from datetime import datetime
 from collections import namedtuple
@@ -35,20 +36,53 @@ def run_command(cmd):
     return output.stdout
 
 
+# Generates the synthetic datasets (if not yet generated) and returns their paths.
+def generate_datasets(key_types, sizes, data_dir):
+    os.makedirs(data_dir, exist_ok=True)
+    input_keys_list = []
+    for key_type in key_types:
+        for size in sizes:
+            input_keys = f'{data_dir}/{key_type}-{size}.txt'
+            if not os.path.exists(input_keys):
+                print(run_command(f'{BUILD_DIR}/gen_dataset {key_type} {size} {input_keys}'), end='')
+            input_keys_list.append(input_keys)
+    return input_keys_list
+
+
+# Adds the dataset name to the JSON lines of the output.
+def tag_dataset(stdout, dataset):
+    lines = []
+    for line in stdout.splitlines():
+        if line.startswith('{'):
+            obj = json.loads(line)
+            obj['dataset'] = dataset
+            line = json.dumps(obj)
+        lines.append(line + '\n')
+    return ''.join(lines)
+
+
 def main():
     parser = ArgumentParser()
-    parser.add_argument('input_keys')
+    parser.add_argument('input_keys', nargs='*')
     parser.add_argument('output_json')
+    parser.add_argument('--gen', help='comma-separated key types to generate with gen_dataset, e.g., url,uuid,int64,ipv4,domain,path')
+    parser.add_argument('--sizes', default='1000000', help='comma-separated numbers of keys to generate')
+    parser.add_argument('--data_dir', default='datasets')
+    parser.add_argument('--bench_args', default='', help='arguments passed to every benchmark, e.g., "-w uniform,miss"')
     args = parser.parse_args()
 
-    input_keys = args.input_keys
+    input_keys_list = list(args.input_keys)
+    if args.gen:
+        input_keys_list += generate_datasets(args.gen.split(','), args.sizes.split(','), args.data_dir)
     output_json = args.output_json
 
     fout = open(output_json, 'wt')
-    for command in COMMANDS:
-        cmd = f'{BUILD_DIR}/{command} {input_keys}'
-        stdout = run_command(cmd)
-        fout.write(stdout)
+    for input_keys in input_keys_list:
+        dataset = os.path.splitext(os.path.basename(input_keys))[0]
+        for command in COMMANDS:
+            cmd = f'{BUILD_DIR}/{command} {input_keys} {args.bench_args}'.rstrip()
+            stdout = run_command(cmd)
+            fout.write(tag_dataset(stdout, dataset))
     fout.close()
 
 
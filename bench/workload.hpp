@@ -0,0 +1,201 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <numeric>
+#include <random>
+#include <string>
+#include <vector>
+
+// Query workloads of the benchmark:
+//  - uniform: keys drawn uniformly at random (every query hits)
+//  - zipf:    keys drawn from a Zipf distribution over a random ranking of the keys
+//  - sorted:  uniform keys in sorted order, as issued by merge joins
+//  - miss:    uniform keys where a miss_ratio fraction is mutated into non-keys
+//  - cold:    uniform keys where the caches are evicted before every query
+struct workload {
+    std::string name;
+    std::vector<std::string> queries;
+    uint64_t num_misses = 0;  // number of queries that are not keys
+    bool cold = false;
+};
+
+struct workload_options {
+    uint64_t num_samples = 100000;
+    uint64_t random_seed = 13;
+    double miss_ratio = 0.5;
+    double zipf_skew = 0.99;
+    uint64_t cold_samples = 1000;  // cold queries are expensive to run
+};
+
+// Zipf distribution over {1,...,n} sampled by rejection-inversion (Hormann and Derflinger, 1996),
+// which needs O(1) space and thus works for any number of keys.
+class zipf_distribution {
+  public:
+    zipf_distribution(uint64_t n, double skew)
+        : m_n(n)
+        , m_skew(skew)
+        , m_h_integral_x1(h_integral(1.5) - 1.0)
+        , m_h_integral_n(h_integral(n + 0.5))
+        , m_s(2.0 - h_integral_inverse(h_integral(2.5) - h(2.0))) {}
+
+    template <class Engine>
+    uint64_t operator()(Engine& engine) {
+        std::uniform_real_distribution<double> dist(0.0, 1.0);
+        while (true) {
+            const double u = m_h_integral_n + dist(engine) * (m_h_integral_x1 - m_h_integral_n);
+            const double x = h_integral_inverse(u);
+            const uint64_t k = std::min<uint64_t>(std::max<int64_t>(int64_t(x + 0.5), 1), m_n);
+            if (k - x <= m_s || u >= h_integral(k + 0.5) - h(double(k))) {
+                return k;
+            }
+        }
+    }
+
+  private:
+    uint64_t m_n;
+    double m_skew;
+    double m_h_integral_x1;
+    double m_h_integral_n;
+    double m_s;
+
+    double h(double x) const {
+        return std::exp(-m_skew * std::log(x));
+    }
+    double h_integral(double x) const {
+        const double log_x = std::log(x);
+        return helper2((1.0 - m_skew) * log_x) * log_x;
+    }
+    double h_integral_inverse(double x) const {
+        const double t = std::max(x * (1.0 - m_skew), -1.0);
+        return std::exp(helper1(t) * x);
+    }
+    // log1p(x)/x and expm1(x)/x, stable around zero
+    static double helper1(double x) {
+        return std::abs(x) > 1e-8 ? std::log1p(x) / x : 1.0 - x * (0.5 - x * (1.0 / 3.0 - 0.25 * x));
+    }
+    static double helper2(double x) {
+        return std::abs(x) > 1e-8 ? std::expm1(x) / x : 1.0 + x * 0.5 * (1.0 + x / 3.0 * (1.0 + 0.25 * x));
+    }
+};
+
+std::vector<std::string> sample_strings(const std::vector<std::string>& strings, std::uint64_t num_samples,
+                                        std::uint64_t random_seed) {
+    std::mt19937_64 engine(random_seed);
+    std::uniform_int_distribution<std::uint64_t> dist(0, strings.size() - 1);
+
+    std::vector<std::string> sampled(num_samples);
+    for (std::uint64_t i = 0; i < num_samples; i++) {
+        sampled[i] = strings[dist(engine)];
+    }
+    return sampled;
+}
+
+std::vector<std::string> sample_zipf_strings(const std::vector<std::string>& strings, std::uint64_t num_samples,
+                                             double skew, std::uint64_t random_seed) {
+    std::mt19937_64 engine(random_seed);
+    zipf_distribution dist(strings.size(), skew);
+
+    // Ranks are scattered over the keys with a stride coprime to their number,
+    // so that the hot keys are not adjacent in the dictionary.
+    const uint64_t n = strings.size();
+    uint64_t stride = 0x9E3779B97F4A7C15ULL % n;
+    while (std::gcd(stride, n) != 1) {
+        stride += 1;
+    }
+
+    std::vector<std::string> sampled(num_samples);
+    for (std::uint64_t i = 0; i < num_samples; i++) {
+        const uint64_t rank = dist(engine) - 1;
+        sampled[i] = strings[(unsigned __int128)rank * stride % n];
+    }
+    return sampled;
+}
+
+// Mutates keys into non-keys by replacing, appending or removing one byte, so that
+// searches leave the trie at various depths and through different exit paths.
+std::vector<std::string> make_negative_strings(const std::vector<std::string>& queries,
+                                               const std::vector<std::string>& sorted_keys, std::uint64_t num_misses,
+                                               std::uint64_t random_seed) {
+    std::mt19937_64 engine(random_seed);
+    std::uniform_int_distribution<int> byte_dist(0x21, 0x7E);
+
+    std::vector<std::string> negatives;
+    for (std::uint64_t i = 0; negatives.size() < num_misses; i++) {
+        std::string query = queries[i % queries.size()];
+        switch (engine() % 3) {
+            case 0:
+                if (!query.empty()) {
+                    query[engine() % query.size()] = char(byte_dist(engine));
+                    break;
+                }
+                [[fallthrough]];
+            case 1:
+                query.push_back(char(byte_dist(engine)));
+                break;
+            default:
+                if (!query.empty()) {
+                    query.pop_back();
+                }
+                break;
+        }
+        if (!query.empty() && !std::binary_search(sorted_keys.begin(), sorted_keys.end(), query)) {
+            negatives.push_back(std::move(query));
+        }
+    }
+    return negatives;
+}
+
+workload make_workload(const std::string& name, const std::vector<std::string>& keys, const workload_options& opts) {
+    workload w;
+    w.name = name;
+    if (name == "uniform") {
+        w.queries = sample_strings(keys, opts.num_samples, opts.random_seed);
+    } else if (name == "zipf") {
+        w.queries = sample_zipf_strings(keys, opts.num_samples, opts.zipf_skew, opts.random_seed);
+    } else if (name == "sorted") {
+        w.queries = sample_strings(keys, opts.num_samples, opts.random_seed);
+        std::sort(w.queries.begin(), w.queries.end());
+    } else if (name == "miss") {
+        std::vector<std::string> sorted_keys;
+        const auto* sorted = &keys;
+        if (!std::is_sorted(keys.begin(), keys.end())) {
+            sorted_keys = keys;
+            std::sort(sorted_keys.begin(), sorted_keys.end());
+            sorted = &sorted_keys;
+        }
+        w.queries = sample_strings(keys, opts.num_samples, opts.random_seed);
+        w.num_misses = uint64_t(opts.num_samples * opts.miss_ratio);
+        auto negatives = make_negative_strings(w.queries, *sorted, w.num_misses, opts.random_seed + 1);
+        std::copy(negatives.begin(), negatives.end(), w.queries.begin());
+        std::shuffle(w.queries.begin(), w.queries.end(), std::mt19937_64(opts.random_seed + 2));
+    } else if (name == "cold") {
+        w.queries = sample_strings(keys, std::min(opts.num_samples, opts.cold_samples), opts.random_seed);
+        w.cold = true;
+    } else {
+        w.name.clear();  // unknown
+    }
+    return w;
+}
+
+// Evicts the caches (and most of the TLB entries) by touching a buffer larger than the LLC.
+class cache_evictor {
+  public:
+    explicit cache_evictor(size_t bytes) : m_lines(bytes / sizeof(line), line{}) {}
+
+    void evict() {
+        uint64_t sum = 0;
+        for (auto& l : m_lines) {
+            sum += l.words[0]++;
+        }
+        m_sink = sum;
+    }
+
+  private:
+    struct alignas(64) line {
+        uint64_t words[8];
+    };
+    std::vector<line> m_lines;
+    volatile uint64_t m_sink = 0;
+};
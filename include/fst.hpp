@@ -1,13 +1,18 @@
 #pragma once
 
+#include <algorithm>
+#include <numeric>
+
 #include "surf/louds_dense.hpp"
 #include "surf/louds_sparse.hpp"
 #include "surf/surf_builder.hpp"
+#include "surf/traversal_stats.hpp"
 
 namespace fst {
 
 using position_t = surf::position_t;
 using level_t = surf::level_t;
+using label_t = surf::label_t;
 using surf::kNotFound;
 
 namespace detail {
@@ -17,6 +22,9 @@ class CompactArray {
     CompactArray() = default;
     CompactArray(const std::vector<uint32_t>& input, const uint32_t bits);
 
+    CompactArray(CompactArray&&) = default;
+    CompactArray& operator=(CompactArray&&) = default;
+
     ~CompactArray() = default;
 
     uint32_t operator[](uint32_t i) const;
@@ -28,46 +36,116 @@ class CompactArray {
     void save(std::ostream& os) const;
     void load(std::istream& is);
 
+    size_t arenaBytes() const;
+    void moveToArena(surf::Arena& arena);
+
   private:
     uint32_t size_ = 0;
     uint32_t mask_ = 0;
     uint32_t bits_ = 0;
-    std::vector<uint32_t> chunks_;
+    size_t num_chunks_ = 0;
+    surf::array_ptr<uint32_t> chunks_;
+};
+
+// A blocked Bloom filter over whole keys. All the probes of a key fall into one 512-bit block
+// (a cache line), so a query touches a single line at the cost of a slightly higher false
+// positive rate than a standard Bloom filter of the same size.
+class BloomFilter {
+  public:
+    BloomFilter() = default;
+    // Takes the hashKey values of the keys.
+    BloomFilter(const std::vector<uint64_t>& hashes, const uint32_t bits_per_key);
+
+    BloomFilter(BloomFilter&&) = default;
+    BloomFilter& operator=(BloomFilter&&) = default;
+
+    ~BloomFilter() = default;
+
+    // Returns false if key is certainly not a key; always true if the filter is empty.
+    bool mayContain(const std::string& key) const;
+
+    bool isEmpty() const;
+    uint64_t getSizeIO() const;
+    uint64_t getMemoryUsage() const;
+
+    void save(std::ostream& os) const;
+    void load(std::istream& is);
+
+    size_t arenaBytes() const;
+    void moveToArena(surf::Arena& arena);
+
+    static uint64_t hashKey(const std::string& key);
+
+  private:
+    struct alignas(64) Block {
+        uint64_t words[8];
+    };
+    static constexpr uint32_t kBlockBits = 512;
+
+    size_t num_blocks_ = 0;
+    uint32_t num_probes_ = 0;
+    surf::array_ptr<Block> blocks_;
 };
 
+// Arrays are serialized as their size followed by the elements.
 template <class T>
-static void saveVec(std::ostream& os, const std::vector<T>& vec) {
-    size_t n = vec.size();
+static void saveArray(std::ostream& os, const surf::array_ptr<T>& arr, size_t n) {
     surf::saveValue(os, n);
-    os.write(reinterpret_cast<const char*>(vec.data()), sizeof(T) * n);
+    surf::saveArray(os, arr, n);
 }
 template <class T>
-static void loadVec(std::istream& is, std::vector<T>& vec) {
-    size_t n = 0;
+static void loadArray(std::istream& is, surf::array_ptr<T>& arr, size_t& n) {
     surf::loadValue(is, n);
-    vec.resize(n);
-    is.read(reinterpret_cast<char*>(vec.data()), sizeof(T) * n);
+    surf::loadArray(is, arr, n);
 }
 template <class T>
-static uint64_t getVecSizeIO(const std::vector<T>& vec) {
-    return sizeof(size_t) + sizeof(T) * vec.size();
+static uint64_t getArraySizeIO(const surf::array_ptr<T>&, size_t n) {
+    return sizeof(size_t) + sizeof(T) * n;
 }
-template <class T>
-static uint64_t getVecMemoryUsage(const std::vector<T>& vec) {
-    return sizeof(T) * vec.size();
-}
-
 }  // namespace detail
 
+// Build parameters of Trie. A larger sparse_dense_ratio puts more levels in LoudsDense, which is
+// faster but larger. The sampling rates trade the space of the rank and select directories for
+// the time of rank and select; they are serialized with the trie. A non-zero bloom_bits_per_key
+// puts a Bloom filter of that many bits per key in front of the trie, so that most lookups of
+// absent keys end after one cache line instead of walking the trie. A non-zero fingerprint_bits
+// packs a hash of each tail of that many bits into its suffix pointer, so that a lookup of an
+// absent key reaching a leaf mostly ends without fetching the tail. The fingerprint is shortened
+// if the pointer word (31 bits) cannot hold it. A non-zero inline_tail_bytes stores the tails
+// of up to that many bytes (at most kMaxInlineTailBytes) in the pointer word itself, so that
+// neither the tail buffer nor the fingerprint is needed for them. rank_select stores the
+// lexicographic rank of every key and of the smallest key below every node, which enables
+// Trie::rank and Trie::select at ceil(log2(num_keys)) bits per key and node.
+struct Config {
+    bool include_dense = surf::kIncludeDense;
+    uint32_t sparse_dense_ratio = surf::kSparseDenseRatio;
+    position_t rank_block_size = 512;  // a power of two, at least 64
+    position_t select_sample_interval = 64;
+    uint32_t bloom_bits_per_key = 0;  // 0 disables the Bloom filter
+    uint32_t fingerprint_bits = 0;  // 0 disables the fingerprints; 8 to 16 is typical
+    uint32_t inline_tail_bytes = 0;  // 0 disables inline tails
+    bool rank_select = false;
+};
+
+static constexpr uint32_t kMaxInlineTailBytes = 3;
+
 class Trie {
   public:
     Trie() = default;
     Trie(const std::vector<std::string>& keys);
     Trie(const std::vector<std::string>& keys, const bool include_dense, const uint32_t sparse_dense_ratio);
+    Trie(const std::vector<std::string>& keys, const Config& config);
+
+    Trie(Trie&&) = default;
+    Trie& operator=(Trie&&) = default;
 
     ~Trie() = default;
 
     position_t exactSearch(const std::string& key) const;
+    // Same as exactSearch(key), reporting the walk as one query to an instrumentation policy
+    // such as surf::TraversalStats (see surf/traversal_stats.hpp).
+    template <class Stats>
+    position_t exactSearch(const std::string& key, Stats& stats) const;
 
     uint64_t getSizeIO() const;
     uint64_t getMemoryUsage() const;
@@ -75,234 +153,1492 @@ class Trie {
     level_t getHeight() const;
     level_t getSparseStartLevel() const;
 
+    // Returns the number of live (not deleted) keys.
     uint64_t getNumKeys() const;
+    // Returns the bound of key IDs, which range over [0, getNumKeyIds()) including deleted keys.
+    uint64_t getNumKeyIds() const;
     uint64_t getNumNodes() const;
     uint64_t getSuffixBytes() const;
+    bool hasBloomFilter() const;
+    uint32_t getFingerprintBits() const;
+    uint32_t getInlineTailBytes() const;
 
     void save(std::ostream& os) const;
     void load(std::istream& is);
 
     void debugPrint(std::ostream& os) const;
 
+    // Ordered traversals, which enumerate keys in lexicographic order. They assume that keys do
+    // not contain '\0', the terminator label.
+    class Iter;
+    Iter begin() const;
+    // Returns the iterator at the smallest key not less than key.
+    Iter lowerBound(const std::string& key) const;
+    // Returns the iterator over the keys starting with prefix.
+    Iter predictiveSearch(const std::string& prefix) const;
+    // Calls fn(key_id, length) for every key that is a prefix of key, shortest first.
+    template <class Fn>
+    void commonPrefixSearch(const std::string& key, Fn fn) const;
+    // Set operations with the live keys of other, in one descent of both tries: the edges of two
+    // nodes on the same path are merged by label (word-wise over the label bitmaps of dense
+    // nodes), and a subtree is entered only if both nodes have its label, so the cost is bounded
+    // by the common paths plus the output rather than a search in other per key.
+    // intersect calls fn(key, key_id, other_key_id) for every key in both tries, and difference
+    // calls fn(key, key_id) for every key not in other, in lexicographic order.
+    template <class Fn>
+    void intersect(const Trie& other, Fn fn) const;
+    template <class Fn>
+    void difference(const Trie& other, Fn fn) const;
+
+    // Rank and select over the keys in lexicographic order (0-based), if built with
+    // Config::rank_select. rank(key) returns the number of keys less than key, and select(i)
+    // returns the iterator at the i-th smallest key, from which the next keys follow.
+    bool hasRankSelect() const;
+    position_t rank(const std::string& key) const;
+    Iter select(position_t i) const;
+    // Returns the number of keys in [left, right).
+    position_t countRange(const std::string& left, const std::string& right) const;
+    // Returns the rank of the key of key_id.
+    position_t getKeyRank(position_t key_id) const;
+    // Returns the number of keys starting with prefix, in one descent.
+    position_t countPrefix(const std::string& prefix) const;
+    // Returns the ranks [first, last) of the keys starting with prefix, in one descent.
+    std::pair<position_t, position_t> getPrefixRange(const std::string& prefix) const;
+
+    // Logical deletion. erase marks the key in a tombstone bitmap over key IDs, so that the
+    // searches and the ordered traversals skip it; the key ID of every other key is kept. Rank,
+    // select and the prefix ranges still count deleted keys, as the ranks are fixed at build, and
+    // select(i) stops at the i-th key even if it is deleted. Deletion is not thread-safe with
+    // concurrent readers. Returns false if key is absent or already deleted.
+    bool erase(const std::string& key);
+    bool isDeleted(position_t key_id) const;
+    uint64_t getNumDeletedKeys() const;
+    // The live key IDs renumber the live keys densely in the order of key IDs, from a rank
+    // directory over the tombstones (32 bits per 64 key IDs). The directory is derived and not
+    // serialized, and erase clears it.
+    void buildLiveKeyIds();
+    bool hasLiveKeyIds() const;
+    // Returns the number of live keys with a key ID less than that of the live key key_id.
+    position_t getLiveKeyId(position_t key_id) const;
+    // Rebuilds the trie from its live keys with config if more than max_deleted_ratio of its keys
+    // are deleted, which renumbers the key IDs. Returns true if it is rebuilt.
+    bool compact(const Config& config, double max_deleted_ratio = 0.25);
+
+    // The root jump table maps the first two bytes of a key directly to the node (or leaf) reached
+    // at level 2, so that traverse() skips the two topmost levels. It takes 256 KiB, is derived
+    // from the trie and is not serialized. Returns false if the trie is too large for the table.
+    bool buildRootJumpTable();
+    void clearRootJumpTable();
+    bool hasRootJumpTable() const;
+
+    // Packing copies all arrays of the trie (including the root jump table, if built) into one
+    // contiguous, cache-line aligned allocation that follows the current surf::AllocPolicy.
+    // This keeps the hot structures adjacent in memory and lets a single huge-page mapping back
+    // the whole trie. load() unpacks the trie.
+    void packIntoArena();
+    bool isPacked() const;
+
   private:
-    std::pair<position_t, level_t> traverse(const std::string& key) const;
+    template <class Stats>
+    std::pair<position_t, level_t> traverse(const std::string& key, Stats& stats) const;
+    template <class Stats>
+    std::pair<position_t, level_t> traverseFrom(const std::string& key, level_t level, position_t node_num,
+                                                Stats& stats) const;
+    position_t searchFrom(const std::string& key, level_t level, position_t node_num) const;
+    template <bool kDifference, class Fn>
+    void descendWith(const Trie& other, Iter& iter, Iter& other_iter, Fn& fn) const;
+    template <bool kDifference, class Fn>
+    void matchEdge(const Trie& other, Iter& iter, Iter& other_iter, Fn& fn) const;
+    template <class Fn>
+    void enumerateEdge(Iter& iter, position_t skip_key_id, Fn& fn) const;
+    Iter seekLowerBound(const std::string& key) const;
+    template <class Stats>
+    bool matchTail(const std::string& key, level_t level, position_t suf_pos, Stats& stats) const;
+    template <class Stats>
+    bool matchLeaf(const std::string& key, level_t level, position_t key_id, Stats& stats) const;
+    // Returns the tail of a leaf terminated by '\0'. An inline tail is decoded into buf.
+    const char* getTail(position_t key_id, char (&buf)[kMaxInlineTailBytes + 1]) const;
+    static uint32_t hashTail(const std::string& key, level_t level);
+    void setRanks(const std::vector<uint32_t>& key_ranks, const std::vector<uint32_t>& node_ranks);
+
+    friend class TrieBuilder;
 
   private:
-    std::unique_ptr<surf::LoudsDense> louds_dense_;
-    std::unique_ptr<surf::LoudsSparse> louds_sparse_;
+    // An entry of root_jumps_ consists of a 3-bit tag and a 29-bit payload (node number or key id).
+    enum RootJumpTag : uint32_t { kJumpNotFound = 0, kJumpLeaf1, kJumpLeaf2, kJumpDense, kJumpSparse };
+    static constexpr uint32_t kJumpTagBits = 3;
+    static constexpr uint32_t kJumpTagMask = (1U << kJumpTagBits) - 1;
+    static constexpr uint32_t kNumRootJumps = 1U << 16;
+
+    surf::Arena arena_;  // empty if not packed
+    surf::LoudsDense louds_dense_;
+    surf::LoudsSparse louds_sparse_;
+    // An entry is either an inline tail (flag bit 1) or a pointer followed by its fingerprint
+    // (flag bit 0). The flag is the lowest bit if inline tails are enabled, and absent otherwise.
     detail::CompactArray suffix_ptrs_;
-    std::vector<char> suffixes_;  // unified
+    uint32_t fingerprint_bits_ = 0;
+    uint32_t inline_tail_bytes_ = 0;
+    detail::CompactArray key_ranks_;  // empty if rank/select is disabled
+    detail::CompactArray node_ranks_;  // rank of the smallest key below each node
+    size_t num_suffix_bytes_ = 0;
+    surf::array_ptr<char> suffixes_;  // unified
     position_t num_keys_ = 0;
+    surf::array_ptr<uint32_t> root_jumps_;  // null if disabled
+    detail::BloomFilter bloom_;  // empty if disabled
+    position_t num_deleted_ = 0;
+    size_t num_tombstone_words_ = 0;
+    surf::array_ptr<uint64_t> tombstones_;  // null until the first deletion
+    surf::array_ptr<uint32_t> tombstone_ranks_;  // deletions before each word; null unless built
+};
+
+// A cursor over the keys in lexicographic order. It refers to the trie, which must outlive it
+// and must not be moved.
+class Trie::Iter {
+  public:
+    Iter() = default;
+
+    bool isValid() const {
+        return key_id_ != kNotFound;
+    }
+    const std::string& getKey() const {
+        return key_;
+    }
+    position_t getKeyId() const {
+        return key_id_;
+    }
+    // Moves to the next key; the iterator becomes invalid after the last one.
+    void operator++(int);
+
+  private:
+    friend class Trie;
+
+    // An edge of a node is a label position. The prefix key of a dense node is an edge before
+    // the labels, while that of a sparse node is the terminator label.
+    struct Frame {
+        position_t node_num;
+        position_t pos;  // label for dense nodes
+        bool is_dense;
+    };
+    static constexpr position_t kPrefixKeyPos = surf::kFanout + 1;
+
+    const Trie* trie_ = nullptr;
+    std::vector<Frame> frames_;  // from the root
+    std::string path_;  // labels leading to the node of frames_.back()
+    std::string prefix_;  // for predictiveSearch
+    std::string key_;
+    position_t key_id_ = kNotFound;
+
+    Iter(const Trie* trie, const std::string& prefix) : trie_(trie), prefix_(prefix) {}
+
+    void pushNode(position_t node_num);
+    bool moveToNextEdge(Frame& frame) const;
+    bool seekEdge(Frame& frame, label_t label) const;
+    label_t getEdgeLabel(const Frame& frame) const;
+    position_t getEdgeChild(const Frame& frame, bool& is_leaf) const;
+    bool descend();
+    void moveToLeftMostKey();
+    position_t getEdgeRank(const Frame& frame) const;
+    void moveToRank(position_t rank);
+    void moveToNextKey();
+    void skipDeleted();
+    void setKey(position_t key_id, bool has_label, label_t label);
+    void clear();
+};
+
+// Builds a Trie from sorted keys given one at a time, so that the key set need not be held in
+// memory: only the tails (the key bytes below the leaves) are kept, which is what
+// Trie(keys, config) does as well. Duplicates are ignored; keys must be non-empty.
+//
+// The builder stays open after snapshot(), so that an append-only key stream can be published
+// periodically without replaying the keys. Only the tails are incremental: a snapshot sorts and
+// shares the tails added since the previous one (not with the older ones) and appends them to
+// the tail store. The rest is rebuilt from a copy of the builder, since the LOUDS bitvectors and
+// their rank/select directories are concatenated over all levels and the key IDs are in level
+// order, so a key added to one level shifts the bits and IDs of the levels below it. A snapshot
+// of n keys therefore takes O(n) time and space, and k snapshots take O(kn).
+class TrieBuilder {
+  public:
+    explicit TrieBuilder(const Config& config = Config());
+
+    TrieBuilder(TrieBuilder&&) = default;
+    TrieBuilder& operator=(TrieBuilder&&) = default;
+
+    ~TrieBuilder() = default;
+
+    // Adds key, which must not be less than the previous one.
+    void add(const std::string& key);
+    // Returns the trie of the keys added so far (an empty trie if none); more keys can follow.
+    // Linear in the number of keys added so far (see above).
+    Trie snapshot();
+    // Same as snapshot(), but the builder is spent. If key_ids is given, (*key_ids)[i] is set to
+    // the key ID of the i-th distinct key added.
+    Trie build(std::vector<position_t>* key_ids = nullptr);
+
+    uint64_t getNumKeys() const;
+
+  private:
+    struct Leaf {
+        level_t level;  // of the leaf label
+        position_t pos_in_level;
+        uint32_t inline_tail;  // kNotFound if the tail is in tails_
+        size_t tail_begin;
+        size_t tail_length;
+    };
+
+    // Inserts the pending key, which is unique in the trie once it differs from next_key.
+    void insertPendingKey(const std::string& next_key);
+    // Records the leaf of key, just inserted into builder.
+    void pushLeaf(const surf::SuRFBuilder& builder, const std::string& key, level_t unique_level);
+    void popLeaf();
+    // Records the smallest key (the next one) below the nodes just created in builder_.
+    void recordNodes(level_t unique_level);
+    // Moves the tails of the new leaves into tail_store_, sharing the common suffixes.
+    void commitTails();
+    Trie assemble(const surf::SuRFBuilder& builder, std::vector<position_t>* key_ids = nullptr) const;
+
+  private:
+    Config config_;
+    uint32_t inline_tail_bytes_ = 0;
+    std::unique_ptr<surf::SuRFBuilder> builder_;
+    std::string pending_key_;  // added but not inserted, as insertion needs the next key
+    bool has_pending_key_ = false;
+    std::vector<Leaf> leaves_;  // in insertion (lexicographic) order
+    std::vector<char> tails_;  // of the leaves from num_committed_
+    position_t num_committed_ = 0;
+    std::vector<char> tail_store_;
+    std::vector<uint32_t> tail_ptrs_;  // into tail_store_, of the committed leaves
+    std::vector<uint32_t> fingerprints_;  // empty if disabled
+    std::vector<uint64_t> bloom_hashes_;  // empty if disabled
+    std::vector<std::vector<position_t>> node_ranks_;  // per level; empty unless rank_select
 };
 
 Trie::Trie(const std::vector<std::string>& keys) : Trie(keys, surf::kIncludeDense, surf::kSparseDenseRatio) {}
 
-Trie::Trie(const std::vector<std::string>& keys, const bool include_dense, const uint32_t sparse_dense_ratio) {
-    auto builder = std::make_unique<surf::SuRFBuilder>(include_dense, sparse_dense_ratio, surf::kNone, 0, 0);
-    builder->build(keys);
-    louds_dense_ = std::make_unique<surf::LoudsDense>(builder.get());
-    louds_sparse_ = std::make_unique<surf::LoudsSparse>(builder.get());
+Trie::Trie(const std::vector<std::string>& keys, const bool include_dense, const uint32_t sparse_dense_ratio)
+    : Trie(keys, Config{include_dense, sparse_dense_ratio}) {}
 
-    num_keys_ = 0;
-    for (level_t level = 0; level < louds_sparse_->getHeight(); ++level) {
-        num_keys_ += builder->getSuffixCounts()[level];
+Trie::Trie(const std::vector<std::string>& keys, const Config& config) {
+    TrieBuilder builder(config);
+    for (const auto& key : keys) {
+        builder.add(key);
     }
+    *this = builder.build();
+}
 
-    struct suffix_t {
-        std::pair<const char*, size_t> str;
-        position_t key_id = kNotFound;
-
-        size_t length() const {
-            return str.second;
-        }
-        char operator[](size_t i) const {
-            return str.first[str.second - i - 1];
+TrieBuilder::TrieBuilder(const Config& config)
+    : config_(config),
+      inline_tail_bytes_(std::min(config.inline_tail_bytes, kMaxInlineTailBytes)),
+      builder_(std::make_unique<surf::SuRFBuilder>(config.include_dense, config.sparse_dense_ratio, surf::kNone, 0,
+                                                   0)) {}
+
+void TrieBuilder::add(const std::string& key) {
+    assert(!key.empty());
+    if (has_pending_key_) {
+        assert(pending_key_ <= key);
+        if (pending_key_ == key) {
+            return;
         }
+        insertPendingKey(key);
+    }
+    pending_key_ = key;
+    has_pending_key_ = true;
+}
 
-        const char* begin() const {
-            return str.first;
-        }
-        const char* end() const {
-            return str.first + str.second;
-        }
+Trie TrieBuilder::snapshot() {
+    if (!has_pending_key_) {
+        return Trie();
+    }
+    commitTails();
+    // The pending key is inserted into a copy, as the next key may push its leaf deeper.
+    surf::SuRFBuilder builder(*builder_);
+    const level_t unique_level = builder.insertKey(pending_key_, std::string());
+    builder.finish();
+    pushLeaf(builder, pending_key_, unique_level);
+    Trie trie = assemble(builder);
+    popLeaf();
+    return trie;
+}
 
-        std::reverse_iterator<const char*> rbegin() const {
-            return std::make_reverse_iterator(str.first + str.second);
+Trie TrieBuilder::build(std::vector<position_t>* key_ids) {
+    if (!has_pending_key_) {
+        if (key_ids != nullptr) {
+            key_ids->clear();
         }
-        std::reverse_iterator<const char*> rend() const {
-            return std::make_reverse_iterator(str.first);
-        }
-    };
+        return Trie();
+    }
+    insertPendingKey(std::string());
+    has_pending_key_ = false;
+    builder_->finish();
+    commitTails();
+    Trie trie = assemble(*builder_, key_ids);
+    builder_.reset();
+    return trie;
+}
 
-    std::vector<suffix_t> suffixes_builder(num_keys_);
+uint64_t TrieBuilder::getNumKeys() const {
+    return leaves_.size() + (has_pending_key_ ? 1 : 0);
+}
 
-    for (position_t i = 0; i < keys.size(); ++i) {
-        if (i != 0 && keys[i] == keys[i - 1]) {
-            continue;
-        }
+void TrieBuilder::insertPendingKey(const std::string& next_key) {
+    const level_t unique_level = builder_->insertKey(pending_key_, next_key);
+    if (config_.rank_select) {
+        recordNodes(unique_level);
+    }
+    pushLeaf(*builder_, pending_key_, unique_level);
+}
 
-        position_t key_id = 0;
-        level_t level = 0;
+void TrieBuilder::pushLeaf(const surf::SuRFBuilder& builder, const std::string& key, const level_t unique_level) {
+    // the leaf is the last suffix of its level; a prefix key ends one level past its bytes
+    const level_t level = std::min<level_t>(unique_level, key.length());
+    const char* tail = key.c_str() + level;
+    const size_t tail_length = key.length() - level;
+
+    Leaf leaf;
+    leaf.level = unique_level - 1;
+    leaf.pos_in_level = builder.getSuffixCounts()[leaf.level] - 1;
+    leaf.tail_begin = tails_.size();
+    leaf.tail_length = tail_length;
+    leaf.inline_tail = kNotFound;
+    if (inline_tail_bytes_ != 0 && tail_length <= inline_tail_bytes_ &&
+        std::find(tail, tail + tail_length, '\0') == tail + tail_length) {
+        leaf.inline_tail = 0;
+        for (size_t j = 0; j < tail_length; ++j) {
+            leaf.inline_tail |= uint32_t(label_t(tail[j])) << (8 * j);
+        }
+        leaf.tail_length = 0;  // keeps it out of the tail buffer
+    } else {
+        tails_.insert(tails_.end(), tail, tail + tail_length);
+    }
+    leaves_.push_back(leaf);
 
-        std::tie(key_id, level) = traverse(keys[i]);
-        assert(key_id < num_keys_);
-        assert(suffixes_builder[key_id].key_id == kNotFound);
-        assert(level <= keys[i].length());
+    if (config_.fingerprint_bits != 0) {
+        fingerprints_.push_back(Trie::hashTail(key, level));
+    }
+    if (config_.bloom_bits_per_key != 0) {
+        bloom_hashes_.push_back(detail::BloomFilter::hashKey(key));
+    }
+}
 
-        auto str = std::make_pair(keys[i].c_str() + level, keys[i].length() - level);
-        suffixes_builder[key_id] = suffix_t{str, key_id};
+void TrieBuilder::popLeaf() {
+    assert(leaves_.size() > num_committed_);
+    tails_.resize(leaves_.back().tail_begin);
+    leaves_.pop_back();
+    if (config_.fingerprint_bits != 0) {
+        fingerprints_.pop_back();
+    }
+    if (config_.bloom_bits_per_key != 0) {
+        bloom_hashes_.pop_back();
     }
+}
 
-    std::sort(suffixes_builder.begin(), suffixes_builder.end(), [](const suffix_t& x, const suffix_t& y) {
-        return std::lexicographical_compare(x.rbegin(), x.rend(), y.rbegin(), y.rend());
-    });
+void TrieBuilder::recordNodes(const level_t unique_level) {
+    // The key creates a node at each level from the one below its common prefix with the
+    // previous key (if that node is new) down to its leaf.
+    const auto& node_counts = builder_->getNodeCounts();
+    if (node_ranks_.size() < node_counts.size()) {
+        node_ranks_.resize(node_counts.size());
+    }
+    for (level_t level = unique_level; level-- > 0 && node_ranks_[level].size() < node_counts[level];) {
+        node_ranks_[level].push_back(position_t(leaves_.size()));
+        assert(node_ranks_[level].size() == node_counts[level]);
+    }
+}
 
-    std::vector<uint32_t> suffix_ptrs(num_keys_);
-    suffixes_.emplace_back('\0');  // for empty suffix
+void TrieBuilder::commitTails() {
+    if (tail_store_.empty()) {
+        tail_store_.emplace_back('\0');  // for empty tails
+    }
+    tail_ptrs_.resize(leaves_.size(), 0);
 
-    suffix_t prev_suffix = {{nullptr, 0}, kNotFound};
+    auto get_tail = [&](const position_t i) {
+        return std::make_pair(tails_.data() + leaves_[i].tail_begin, leaves_[i].tail_length);
+    };
+    auto rbegin = [](const std::pair<const char*, size_t>& tail) {
+        return std::make_reverse_iterator(tail.first + tail.second);
+    };
+    auto rend = [](const std::pair<const char*, size_t>& tail) { return std::make_reverse_iterator(tail.first); };
 
-    for (size_t i = 0; i < num_keys_; ++i) {
-        const suffix_t& curr_suffix = suffixes_builder[num_keys_ - i - 1];
-        if (curr_suffix.length() == 0) {
-            suffix_ptrs[curr_suffix.key_id] = 0;
-            continue;
+    // In the decreasing order of the reversed tails, a tail follows the tails it is a suffix of.
+    std::vector<position_t> order;
+    for (position_t i = num_committed_; i < leaves_.size(); ++i) {
+        if (leaves_[i].tail_length != 0) {
+            order.push_back(i);
         }
+    }
+    std::sort(order.begin(), order.end(), [&](const position_t x, const position_t y) {
+        const auto x_tail = get_tail(x);
+        const auto y_tail = get_tail(y);
+        return std::lexicographical_compare(rbegin(y_tail), rend(y_tail), rbegin(x_tail), rend(x_tail));
+    });
 
-        size_t match = 0;
-        while ((match < curr_suffix.length()) && (match < prev_suffix.length()) &&
-               (prev_suffix[match] == curr_suffix[match])) {
-            ++match;
+    position_t prev = kNotFound;
+    for (const position_t i : order) {
+        const auto curr_tail = get_tail(i);
+        if (prev != kNotFound) {
+            const auto prev_tail = get_tail(prev);
+            const auto mismatch = std::mismatch(rbegin(curr_tail), rend(curr_tail), rbegin(prev_tail), rend(prev_tail));
+            if (mismatch.first == rend(curr_tail)) {  // share
+                tail_ptrs_[i] = tail_ptrs_[prev] + uint32_t(prev_tail.second - curr_tail.second);
+                prev = i;
+                continue;
+            }
         }
+        tail_ptrs_[i] = static_cast<uint32_t>(tail_store_.size());  // append
+        tail_store_.insert(tail_store_.end(), curr_tail.first, curr_tail.first + curr_tail.second);
+        tail_store_.emplace_back('\0');
+        prev = i;
+    }
 
-        if ((match == curr_suffix.length()) && (prev_suffix.length() != 0)) {  // share
-            suffix_ptrs[curr_suffix.key_id] =
-                static_cast<position_t>(suffix_ptrs[prev_suffix.key_id] + (prev_suffix.length() - match));
-        } else {  // append
-            suffix_ptrs[curr_suffix.key_id] = static_cast<position_t>(suffixes_.size());
-            std::copy(curr_suffix.begin(), curr_suffix.end(), std::back_inserter(suffixes_));
-            suffixes_.emplace_back('\0');
-        }
+    tails_.clear();
+    num_committed_ = position_t(leaves_.size());
+}
+
+Trie TrieBuilder::assemble(const surf::SuRFBuilder& builder, std::vector<position_t>* key_ids) const {
+    Trie trie;
+    trie.louds_dense_ = surf::LoudsDense(&builder, config_.rank_block_size);
+    trie.louds_sparse_ = surf::LoudsSparse(&builder, config_.rank_block_size, config_.select_sample_interval);
 
-        prev_suffix = curr_suffix;
+    const position_t num_keys = static_cast<position_t>(leaves_.size());
+    trie.num_keys_ = num_keys;
+    assert(num_keys ==
+           std::accumulate(builder.getSuffixCounts().begin(), builder.getSuffixCounts().end(), position_t(0)));
+
+    // Key IDs number the leaves in level order, as the suffixes are counted per level.
+    std::vector<position_t> level_offsets(builder.getSuffixCounts().size() + 1, 0);
+    for (level_t level = 0; level < builder.getSuffixCounts().size(); ++level) {
+        level_offsets[level + 1] = level_offsets[level] + builder.getSuffixCounts()[level];
+    }
+
+    // The tail buffer is the tail store followed by the uncommitted tails, which are not shared.
+    size_t num_suffix_bytes = tail_store_.size();
+    for (position_t i = num_committed_; i < num_keys; ++i) {
+        num_suffix_bytes += leaves_[i].tail_length != 0 ? leaves_[i].tail_length + 1 : 0;
     }
+    trie.num_suffix_bytes_ = num_suffix_bytes;
+    trie.suffixes_ = surf::makeArray<char>(num_suffix_bytes);
+    std::copy(tail_store_.begin(), tail_store_.end(), trie.suffixes_.get());
 
     uint32_t suf_bits = 0;
-    uint32_t max_ptr = static_cast<uint32_t>(suffixes_.size());
+    uint32_t max_ptr = static_cast<uint32_t>(num_suffix_bytes);
     do {
         suf_bits += 1;
         max_ptr >>= 1;
     } while (max_ptr != 0);
 
-    suffix_ptrs_ = detail::CompactArray(suffix_ptrs, suf_bits);
-    suffixes_.shrink_to_fit();
-}
+    trie.inline_tail_bytes_ = inline_tail_bytes_;
+    const uint32_t flag_bits = inline_tail_bytes_ != 0 ? 1 : 0;
+    trie.fingerprint_bits_ = std::min(config_.fingerprint_bits, 31 - std::min<uint32_t>(suf_bits + flag_bits, 31));
+    const uint32_t fingerprint_mask = (1U << trie.fingerprint_bits_) - 1;
 
-position_t Trie::exactSearch(const std::string& key) const {
-    position_t key_id = 0;
-    level_t level = 0;
+    std::vector<uint32_t> suffix_ptrs(num_keys);
+    std::vector<uint32_t> key_ranks(config_.rank_select ? num_keys : 0);
+    if (key_ids != nullptr) {
+        key_ids->resize(num_keys);
+    }
+    size_t next_ptr = tail_store_.size();
+    for (position_t i = 0; i < num_keys; ++i) {
+        const Leaf& leaf = leaves_[i];
+        const position_t key_id = level_offsets[leaf.level] + leaf.pos_in_level;
+        assert(key_id < num_keys);
+
+        uint32_t entry = 0;
+        if (i < num_committed_) {
+            entry = tail_ptrs_[i];
+        } else if (leaf.tail_length != 0) {
+            entry = static_cast<uint32_t>(next_ptr);
+            std::copy_n(tails_.data() + leaf.tail_begin, leaf.tail_length, trie.suffixes_.get() + next_ptr);
+            next_ptr += leaf.tail_length + 1;  // followed by the zero terminator
+        }
+        if (trie.fingerprint_bits_ != 0) {
+            entry = (entry << trie.fingerprint_bits_) | (fingerprints_[i] & fingerprint_mask);
+        }
+        if (inline_tail_bytes_ != 0) {
+            entry = leaf.inline_tail != kNotFound ? (leaf.inline_tail << 1) | 1 : entry << 1;
+        }
+        suffix_ptrs[key_id] = entry;
+        if (config_.rank_select) {
+            key_ranks[key_id] = i;  // the keys are inserted in order
+        }
+        if (key_ids != nullptr) {
+            (*key_ids)[i] = key_id;
+        }
+    }
+    assert(next_ptr == num_suffix_bytes);
 
-    std::tie(key_id, level) = traverse(key);
-    if (key_id == kNotFound) {
-        return kNotFound;
+    suf_bits += trie.fingerprint_bits_;
+    if (inline_tail_bytes_ != 0) {
+        suf_bits = std::max(suf_bits, 8 * inline_tail_bytes_) + 1;
     }
+    trie.suffix_ptrs_ = detail::CompactArray(suffix_ptrs, suf_bits);
 
-    position_t suf_pos = suffix_ptrs_[key_id];
-    for (; level < key.length(); ++level) {
-        if (key[level] != suffixes_[suf_pos]) {
-            return kNotFound;
+    if (config_.bloom_bits_per_key != 0) {
+        trie.bloom_ = detail::BloomFilter(bloom_hashes_, config_.bloom_bits_per_key);
+    }
+    if (config_.rank_select) {
+        // Node numbers follow the level order as well. A node not recorded yet was created by
+        // the pending key of a snapshot, the last key.
+        std::vector<uint32_t> node_ranks(trie.getNumNodes(), kNotFound);
+        const auto& node_counts = builder.getNodeCounts();
+        position_t node_num = 0;
+        for (level_t level = 0; level < node_counts.size(); ++level) {
+            for (position_t j = 0; j < node_counts[level]; ++j, ++node_num) {
+                const bool is_recorded = level < node_ranks_.size() && j < node_ranks_[level].size();
+                node_ranks[node_num] = is_recorded ? node_ranks_[level][j] : num_keys - 1;
+            }
         }
-        ++suf_pos;
+        trie.setRanks(key_ranks, node_ranks);
     }
-    if (suffixes_[suf_pos] != '\0') {
+    return trie;
+}
+
+position_t Trie::exactSearch(const std::string& key) const {
+    surf::NoStats stats;
+    return exactSearch(key, stats);
+}
+
+template <class Stats>
+position_t Trie::exactSearch(const std::string& key, Stats& stats) const {
+    stats.beginQuery();
+    if (!bloom_.mayContain(key)) {
+        stats.onBloomReject();
+        stats.endQuery();
         return kNotFound;
     }
+
+    position_t key_id = 0;
+    level_t level = 0;
+
+    std::tie(key_id, level) = traverse(key, stats);
+    if (key_id != kNotFound && (!matchLeaf(key, level, key_id, stats) || isDeleted(key_id))) {
+        key_id = kNotFound;
+    }
+
+    stats.endQuery();
     return key_id;
 }
 
 uint64_t Trie::getSizeIO() const {
-    return louds_dense_->serializedSize() + louds_sparse_->serializedSize() + suffix_ptrs_.getSizeIO() +
-           detail::getVecSizeIO(suffixes_) + sizeof(num_keys_);
+    return louds_dense_.serializedSize() + louds_sparse_.serializedSize() + suffix_ptrs_.getSizeIO() +
+           detail::getArraySizeIO(suffixes_, num_suffix_bytes_) + sizeof(num_keys_) + bloom_.getSizeIO() +
+           sizeof(fingerprint_bits_) + sizeof(inline_tail_bytes_) + key_ranks_.getSizeIO() + node_ranks_.getSizeIO() +
+           sizeof(num_deleted_) + detail::getArraySizeIO(tombstones_, num_tombstone_words_);
 }
 
 uint64_t Trie::getMemoryUsage() const {
-    return sizeof(Trie) + louds_dense_->getMemoryUsage() + louds_sparse_->getMemoryUsage() +
-           suffix_ptrs_.getMemoryUsage() + detail::getVecMemoryUsage(suffixes_);
+    // the LOUDS structures are held in place and thus already counted in sizeof(Trie)
+    return sizeof(Trie) + (louds_dense_.getMemoryUsage() - sizeof(louds_dense_)) +
+           (louds_sparse_.getMemoryUsage() - sizeof(louds_sparse_)) + suffix_ptrs_.getMemoryUsage() +
+           num_suffix_bytes_ + (root_jumps_ ? sizeof(uint32_t) * kNumRootJumps : 0) + bloom_.getMemoryUsage() +
+           key_ranks_.getMemoryUsage() + node_ranks_.getMemoryUsage() + sizeof(uint64_t) * num_tombstone_words_ +
+           (tombstone_ranks_ ? sizeof(uint32_t) * num_tombstone_words_ : 0);
 }
 
 level_t Trie::getHeight() const {
-    return louds_sparse_->getHeight();
+    return louds_sparse_.getHeight();
 }
 
 level_t Trie::getSparseStartLevel() const {
-    return louds_sparse_->getStartLevel();
+    return louds_sparse_.getStartLevel();
 }
 
 uint64_t Trie::getNumKeys() const {
+    return num_keys_ - num_deleted_;
+}
+
+uint64_t Trie::getNumKeyIds() const {
     return num_keys_;
 }
 
 uint64_t Trie::getNumNodes() const {
-    return louds_dense_->getNumNodes() + louds_sparse_->getNumNodes();
+    return louds_dense_.getNumNodes() + louds_sparse_.getNumNodes();
 }
 uint64_t Trie::getSuffixBytes() const {
-    return suffixes_.size();
+    return num_suffix_bytes_;
+}
+
+bool Trie::hasBloomFilter() const {
+    return !bloom_.isEmpty();
+}
+
+uint32_t Trie::getFingerprintBits() const {
+    return fingerprint_bits_;
+}
+
+uint32_t Trie::getInlineTailBytes() const {
+    return inline_tail_bytes_;
 }
 
 void Trie::save(std::ostream& os) const {
-    louds_dense_->save(os);
-    louds_sparse_->save(os);
+    louds_dense_.save(os);
+    louds_sparse_.save(os);
     suffix_ptrs_.save(os);
-    detail::saveVec(os, suffixes_);
+    detail::saveArray(os, suffixes_, num_suffix_bytes_);
     surf::saveValue(os, num_keys_);
+    bloom_.save(os);
+    surf::saveValue(os, fingerprint_bits_);
+    surf::saveValue(os, inline_tail_bytes_);
+    key_ranks_.save(os);
+    node_ranks_.save(os);
+    surf::saveValue(os, num_deleted_);
+    detail::saveArray(os, tombstones_, num_tombstone_words_);
 }
 
 void Trie::load(std::istream& is) {
-    louds_dense_ = std::make_unique<surf::LoudsDense>();
-    louds_dense_->load(is);
-    louds_sparse_ = std::make_unique<surf::LoudsSparse>();
-    louds_sparse_->load(is);
+    root_jumps_.reset();
+    tombstone_ranks_.reset();
+    louds_dense_.load(is);
+    louds_sparse_.load(is);
     suffix_ptrs_.load(is);
-    detail::loadVec(is, suffixes_);
+    detail::loadArray(is, suffixes_, num_suffix_bytes_);
     surf::loadValue(is, num_keys_);
+    bloom_.load(is);
+    surf::loadValue(is, fingerprint_bits_);
+    surf::loadValue(is, inline_tail_bytes_);
+    key_ranks_.load(is);
+    node_ranks_.load(is);
+    surf::loadValue(is, num_deleted_);
+    detail::loadArray(is, tombstones_, num_tombstone_words_);
+    if (num_tombstone_words_ == 0) {
+        tombstones_.reset();
+    }
+    arena_ = surf::Arena();  // every array has been reallocated
 }
 
 void Trie::debugPrint(std::ostream& os) const {
-    louds_dense_->debugPrint(os);
-    louds_sparse_->debugPrint(os);
+    louds_dense_.debugPrint(os);
+    louds_sparse_.debugPrint(os);
     os << "-- Suffixes --" << std::endl;
-    os << "POINTERS: ";
+    os << "TAILS: ";
     for (uint32_t i = 0; i < suffix_ptrs_.getSize(); ++i) {
-        os << suffix_ptrs_[i] << " ";
+        char buf[kMaxInlineTailBytes + 1];
+        os << '"' << getTail(i, buf) << "\" ";
     }
     os << '\n';
     os << "SUFFIXES: ";
-    for (size_t i = 0; i < suffixes_.size(); ++i) {
+    for (size_t i = 0; i < num_suffix_bytes_; ++i) {
         char c = suffixes_[i];
         os << (c ? c : '?') << " ";
     }
     os << std::endl;
 }
 
-std::pair<position_t, level_t> Trie::traverse(const std::string& key) const {
+bool Trie::erase(const std::string& key) {
+    const position_t key_id = exactSearch(key);
+    if (key_id == kNotFound) {
+        return false;
+    }
+    if (!tombstones_) {
+        num_tombstone_words_ = (num_keys_ + 63) / 64;
+        tombstones_ = surf::makeArray<uint64_t>(num_tombstone_words_);
+    }
+    tombstones_[key_id / 64] |= uint64_t(1) << (key_id % 64);
+    ++num_deleted_;
+    tombstone_ranks_.reset();
+    return true;
+}
+
+bool Trie::isDeleted(const position_t key_id) const {
+    return num_deleted_ != 0 && ((tombstones_[key_id / 64] >> (key_id % 64)) & 1) != 0;
+}
+
+uint64_t Trie::getNumDeletedKeys() const {
+    return num_deleted_;
+}
+
+void Trie::buildLiveKeyIds() {
+    tombstone_ranks_ = surf::makeArray<uint32_t>(num_tombstone_words_);
+    uint32_t num_deleted = 0;
+    for (size_t i = 0; i < num_tombstone_words_; ++i) {
+        tombstone_ranks_[i] = num_deleted;
+        num_deleted += uint32_t(__builtin_popcountll(tombstones_[i]));
+    }
+}
+
+bool Trie::hasLiveKeyIds() const {
+    return num_deleted_ == 0 || tombstone_ranks_ != nullptr;
+}
+
+position_t Trie::getLiveKeyId(const position_t key_id) const {
+    assert(hasLiveKeyIds());
+    assert(!isDeleted(key_id));
+    if (num_deleted_ == 0) {
+        return key_id;
+    }
+    const uint64_t below = tombstones_[key_id / 64] & ((uint64_t(1) << (key_id % 64)) - 1);
+    return key_id - tombstone_ranks_[key_id / 64] - position_t(__builtin_popcountll(below));
+}
+
+bool Trie::compact(const Config& config, const double max_deleted_ratio) {
+    if (num_deleted_ == 0 || num_deleted_ <= max_deleted_ratio * num_keys_) {
+        return false;
+    }
+    TrieBuilder builder(config);
+    for (Iter iter = begin(); iter.isValid(); iter++) {
+        builder.add(iter.getKey());
+    }
+    const bool has_root_jumps = hasRootJumpTable();
+    const bool is_packed = isPacked();
+    *this = builder.build();
+    if (has_root_jumps) {
+        buildRootJumpTable();
+    }
+    if (is_packed) {
+        packIntoArena();
+    }
+    return true;
+}
+
+bool Trie::buildRootJumpTable() {
+    root_jumps_.reset();
+    if (num_keys_ == 0) {
+        return false;
+    }
+
+    const level_t dense_height = louds_dense_.getHeight();
+    auto move_to_child = [&](level_t level, position_t node_num, label_t label, bool& is_leaf) {
+        return level < dense_height ? louds_dense_.moveToChild(node_num, label, is_leaf)
+                                    : louds_sparse_.moveToChild(node_num, label, is_leaf);
+    };
+
+    auto root_jumps = surf::makeArray<uint32_t>(kNumRootJumps);  // filled with kJumpNotFound
+    for (uint32_t c0 = 0; c0 < surf::kFanout; ++c0) {
+        bool is_leaf = false;
+        const position_t ret0 = move_to_child(0, 0, label_t(c0), is_leaf);
+        if (ret0 == kNotFound) {
+            continue;
+        }
+        if ((ret0 >> (32 - kJumpTagBits)) != 0) {
+            return false;
+        }
+        if (is_leaf) {
+            std::fill_n(&root_jumps[c0 << 8], surf::kFanout, (ret0 << kJumpTagBits) | kJumpLeaf1);
+            continue;
+        }
+        for (uint32_t c1 = 0; c1 < surf::kFanout; ++c1) {
+            const position_t ret1 = move_to_child(1, ret0, label_t(c1), is_leaf);
+            if (ret1 == kNotFound) {
+                continue;
+            }
+            if ((ret1 >> (32 - kJumpTagBits)) != 0) {
+                return false;
+            }
+            const uint32_t tag = is_leaf ? kJumpLeaf2 : (dense_height > 2 ? kJumpDense : kJumpSparse);
+            root_jumps[(c0 << 8) | c1] = (ret1 << kJumpTagBits) | tag;
+        }
+    }
+    root_jumps_ = std::move(root_jumps);
+    return true;
+}
+
+void Trie::clearRootJumpTable() {
+    root_jumps_.reset();
+}
+
+bool Trie::hasRootJumpTable() const {
+    return root_jumps_ != nullptr;
+}
+
+void Trie::packIntoArena() {
+    const size_t bytes = louds_dense_.arenaBytes() + louds_sparse_.arenaBytes() + suffix_ptrs_.arenaBytes() +
+                         surf::Arena::footprint<char>(num_suffix_bytes_) +
+                         (root_jumps_ ? surf::Arena::footprint<uint32_t>(kNumRootJumps) : 0) + bloom_.arenaBytes() +
+                         key_ranks_.arenaBytes() + node_ranks_.arenaBytes() +
+                         (tombstones_ ? surf::Arena::footprint<uint64_t>(num_tombstone_words_) : 0) +
+                         (tombstone_ranks_ ? surf::Arena::footprint<uint32_t>(num_tombstone_words_) : 0);
+    surf::Arena arena(bytes);
+    louds_dense_.moveToArena(arena);
+    louds_sparse_.moveToArena(arena);
+    suffix_ptrs_.moveToArena(arena);
+    arena.relocate(suffixes_, num_suffix_bytes_);
+    arena.relocate(root_jumps_, kNumRootJumps);
+    bloom_.moveToArena(arena);
+    key_ranks_.moveToArena(arena);
+    node_ranks_.moveToArena(arena);
+    arena.relocate(tombstones_, num_tombstone_words_);
+    arena.relocate(tombstone_ranks_, num_tombstone_words_);
+    assert(arena.used() == arena.capacity());
+    arena_ = std::move(arena);  // releases the previous arena, if any
+}
+
+bool Trie::isPacked() const {
+    return arena_.capacity() != 0;
+}
+
+template <class Stats>
+std::pair<position_t, level_t> Trie::traverse(const std::string& key, Stats& stats) const {
     position_t connect_node_num = 0;
-    auto ret = louds_dense_->findKey(key, connect_node_num);
+    std::pair<position_t, level_t> ret;
+    if (root_jumps_ && key.length() >= 2) {
+        stats.onRootJump();
+        const uint32_t jump = root_jumps_[(uint32_t(label_t(key[0])) << 8) | label_t(key[1])];
+        const position_t value = jump >> kJumpTagBits;
+        switch (jump & kJumpTagMask) {
+            case kJumpLeaf1:
+                return {value, 1};
+            case kJumpLeaf2:
+                return {value, 2};
+            case kJumpDense:
+                ret = louds_dense_.findKey(key, 2, value, connect_node_num, stats);
+                break;
+            case kJumpSparse:
+                return louds_sparse_.findKey(key, value, 2, stats);
+            default:
+                return {kNotFound, 2};
+        }
+    } else {
+        ret = louds_dense_.findKey(key, 0, 0, connect_node_num, stats);
+    }
     if (ret.first != kNotFound) {
         return ret;
     }
     if (connect_node_num != kNotFound) {
-        return louds_sparse_->findKey(key, connect_node_num);
+        return louds_sparse_.findKey(key, connect_node_num, louds_sparse_.getStartLevel(), stats);
     }
     return ret;
 }
 
+// Same as traverse, but starting from the node node_num at level.
+template <class Stats>
+std::pair<position_t, level_t> Trie::traverseFrom(const std::string& key, const level_t level,
+                                                  const position_t node_num, Stats& stats) const {
+    if (level >= louds_dense_.getHeight()) {
+        return louds_sparse_.findKey(key, node_num, level, stats);
+    }
+    position_t connect_node_num = 0;
+    const std::pair<position_t, level_t> ret = louds_dense_.findKey(key, level, node_num, connect_node_num, stats);
+    if (ret.first != kNotFound || connect_node_num == kNotFound) {
+        return ret;
+    }
+    return louds_sparse_.findKey(key, connect_node_num, louds_sparse_.getStartLevel(), stats);
+}
+
+// Returns the key ID of key if it is a live key below the node node_num at level, or kNotFound.
+position_t Trie::searchFrom(const std::string& key, const level_t level, const position_t node_num) const {
+    surf::NoStats stats;
+    position_t key_id = kNotFound;
+    level_t leaf_level = 0;
+    std::tie(key_id, leaf_level) = traverseFrom(key, level, node_num, stats);
+    if (key_id != kNotFound && (!matchLeaf(key, leaf_level, key_id, stats) || isDeleted(key_id))) {
+        return kNotFound;
+    }
+    return key_id;
+}
+
+Trie::Iter Trie::begin() const {
+    return lowerBound("");
+}
+
+Trie::Iter Trie::lowerBound(const std::string& key) const {
+    Iter iter = seekLowerBound(key);
+    iter.skipDeleted();
+    return iter;
+}
+
+// Same as lowerBound, but stopping at deleted keys as well.
+Trie::Iter Trie::seekLowerBound(const std::string& key) const {
+    Iter iter(this, "");
+    if (num_keys_ == 0) {
+        return iter;
+    }
+    // walk down while the key matches; the edges taken are the smallest not less than the key bytes
+    iter.pushNode(0);
+    for (level_t level = 0;; ++level) {
+        if (level == key.length()) {
+            iter.moveToLeftMostKey();  // every key of the subtree has key as a prefix
+            return iter;
+        }
+        Iter::Frame& frame = iter.frames_.back();
+        const label_t c = label_t(key[level]);
+        label_t label = 0;
+        if (frame.is_dense) {
+            const position_t next = louds_dense_.nextLabel(frame.node_num, c);
+            if (next == surf::kFanout) {  // every key of the subtree is less than key
+                frame.pos = surf::kFanout - 1;
+                iter.moveToNextKey();
+                return iter;
+            }
+            frame.pos = next;
+            label = label_t(next);
+        } else {
+            position_t pos = louds_sparse_.getFirstPos(frame.node_num);
+            while (louds_sparse_.getLabel(pos) < c) {
+                const position_t next = louds_sparse_.getNextPosInNode(pos);
+                if (next == kNotFound) {
+                    frame.pos = pos;
+                    iter.moveToNextKey();
+                    return iter;
+                }
+                pos = next;
+            }
+            frame.pos = pos;
+            label = louds_sparse_.getLabel(pos);
+        }
+        if (label != c) {
+            iter.moveToLeftMostKey();
+            return iter;
+        }
+        bool is_leaf = false;
+        const position_t child = frame.is_dense ? louds_dense_.moveToChild(frame.node_num, label, is_leaf)
+                                                : louds_sparse_.getChild(frame.pos, is_leaf);
+        if (is_leaf) {
+            iter.setKey(child, true, label);
+            if (iter.key_ < key) {
+                iter.moveToNextKey();
+            }
+            return iter;
+        }
+        iter.path_.push_back(char(label));
+        iter.pushNode(child);
+    }
+}
+
+Trie::Iter Trie::predictiveSearch(const std::string& prefix) const {
+    Iter iter = lowerBound(prefix);
+    iter.prefix_ = prefix;
+    if (iter.isValid() && iter.key_.compare(0, prefix.length(), prefix) != 0) {
+        iter.clear();
+    }
+    return iter;
+}
+
+template <class Fn>
+void Trie::commonPrefixSearch(const std::string& key, Fn fn) const {
+    if (num_keys_ == 0) {
+        return;
+    }
+    const level_t dense_height = louds_dense_.getHeight();
+    position_t node_num = 0;
+    for (level_t level = 0;; ++level) {
+        bool is_leaf = false;
+        position_t child = kNotFound;
+        if (level < dense_height) {
+            const position_t key_id = louds_dense_.getPrefixKeyId(node_num);
+            if (key_id != kNotFound && !isDeleted(key_id)) fn(key_id, size_t(level));
+            if (level == key.length()) return;
+            child = louds_dense_.moveToChild(node_num, label_t(key[level]), is_leaf);
+        } else {
+            const position_t pos = louds_sparse_.getFirstPos(node_num);
+            if (louds_sparse_.getLabel(pos) == surf::kTerminator) {
+                const position_t key_id = louds_sparse_.getChild(pos, is_leaf);
+                if (is_leaf && !isDeleted(key_id)) fn(key_id, size_t(level));
+            }
+            if (level == key.length()) return;
+            child = louds_sparse_.moveToChild(node_num, label_t(key[level]), is_leaf);
+        }
+        if (child == kNotFound) {
+            return;
+        }
+        if (is_leaf) {
+            // the key of the leaf is a prefix of key if its tail is
+            char buf[kMaxInlineTailBytes + 1];
+            const char* tail = getTail(child, buf);
+            size_t length = level + 1;
+            while (*tail != '\0' && length < key.length() && *tail == key[length]) {
+                ++tail;
+                ++length;
+            }
+            if (*tail == '\0' && !isDeleted(child)) fn(child, length);
+            return;
+        }
+        node_num = child;
+    }
+}
+
+template <class Fn>
+void Trie::intersect(const Trie& other, Fn fn) const {
+    if (num_keys_ == 0 || other.num_keys_ == 0) {
+        return;
+    }
+    Iter iter(this, ""), other_iter(&other, "");
+    iter.pushNode(0);
+    other_iter.pushNode(0);
+    descendWith<false>(other, iter, other_iter, fn);
+}
+
+template <class Fn>
+void Trie::difference(const Trie& other, Fn fn) const {
+    if (other.num_keys_ == 0) {
+        for (Iter iter = begin(); iter.isValid(); iter++) {
+            fn(iter.getKey(), iter.getKeyId());
+        }
+        return;
+    }
+    if (num_keys_ == 0) {
+        return;
+    }
+    Iter iter(this, ""), other_iter(&other, "");
+    iter.pushNode(0);
+    other_iter.pushNode(0);
+    descendWith<true>(other, iter, other_iter, fn);
+}
+
+// Merges the edges of the deepest nodes of iter and other_iter, which are on the same path, and
+// handles each edge of iter in label order. The frames are indexed since matchEdge pushes more.
+template <bool kDifference, class Fn>
+void Trie::descendWith(const Trie& other, Iter& iter, Iter& other_iter, Fn& fn) const {
+    const size_t depth = iter.frames_.size() - 1;
+    const position_t node_num = iter.frames_[depth].node_num;
+    const position_t other_node_num = other_iter.frames_[depth].node_num;
+
+    if (iter.frames_[depth].is_dense && other_iter.frames_[depth].is_dense) {
+        // The common labels are the AND of the label bitmaps, a word at a time.
+        if (iter.frames_[depth].pos == Iter::kPrefixKeyPos) {
+            if (other_iter.frames_[depth].pos == Iter::kPrefixKeyPos) {
+                matchEdge<kDifference>(other, iter, other_iter, fn);
+            } else if constexpr (kDifference) {
+                enumerateEdge(iter, kNotFound, fn);
+            }
+        }
+        for (position_t i = 0; i < surf::kFanout / surf::kWordSize; ++i) {
+            const surf::word_t other_word = other.louds_dense_.getLabelWord(other_node_num, i);
+            surf::word_t word = louds_dense_.getLabelWord(node_num, i);
+            if constexpr (!kDifference) {
+                word &= other_word;
+            }
+            while (word != 0) {
+                const position_t offset = position_t(__builtin_clzll(word));
+                word &= ~(surf::kMsbMask >> offset);
+                iter.frames_[depth].pos = i * surf::kWordSize + offset;
+                if ((other_word << offset) & surf::kMsbMask) {
+                    other_iter.frames_[depth].pos = iter.frames_[depth].pos;
+                    matchEdge<kDifference>(other, iter, other_iter, fn);
+                } else if constexpr (kDifference) {
+                    enumerateEdge(iter, kNotFound, fn);
+                }
+            }
+        }
+        return;
+    }
+
+    // Otherwise the sorted labels are merged, each side seeking the label of the other.
+    bool other_valid = true;
+    for (;;) {
+        const label_t label = iter.getEdgeLabel(iter.frames_[depth]);
+        other_valid = other_valid && other_iter.seekEdge(other_iter.frames_[depth], label);
+        if (other_valid && other_iter.getEdgeLabel(other_iter.frames_[depth]) == label) {
+            matchEdge<kDifference>(other, iter, other_iter, fn);
+        } else if constexpr (kDifference) {
+            enumerateEdge(iter, kNotFound, fn);
+        } else if (!other_valid ||
+                   !iter.seekEdge(iter.frames_[depth], other_iter.getEdgeLabel(other_iter.frames_[depth]))) {
+            return;
+        } else {
+            continue;  // at the label of other, or past it
+        }
+        if (!iter.moveToNextEdge(iter.frames_[depth])) {
+            return;
+        }
+    }
+}
+
+// Handles the current edges of the deepest nodes of iter and other_iter, which have the same label.
+template <bool kDifference, class Fn>
+void Trie::matchEdge(const Trie& other, Iter& iter, Iter& other_iter, Fn& fn) const {
+    const label_t label = iter.getEdgeLabel(iter.frames_.back());
+    bool is_leaf = false, other_is_leaf = false;
+    const position_t child = iter.getEdgeChild(iter.frames_.back(), is_leaf);
+    const position_t other_child = other_iter.getEdgeChild(other_iter.frames_.back(), other_is_leaf);
+    const level_t level = level_t(iter.path_.size()) + 1;  // of the children
+
+    if (!is_leaf && !other_is_leaf) {
+        iter.path_.push_back(char(label));
+        iter.pushNode(child);
+        other_iter.path_.push_back(char(label));
+        other_iter.pushNode(other_child);
+        descendWith<kDifference>(other, iter, other_iter, fn);
+        iter.frames_.pop_back();
+        iter.path_.pop_back();
+        other_iter.frames_.pop_back();
+        other_iter.path_.pop_back();
+        return;
+    }
+
+    if (is_leaf) {
+        // a single key of this trie, searched for below the edge of other
+        if (isDeleted(child)) {
+            return;
+        }
+        iter.setKey(child, label != surf::kTerminator, label);
+        position_t other_key_id = kNotFound;
+        if (!other_is_leaf) {
+            other_key_id = other.searchFrom(iter.key_, level, other_child);
+        } else if (!other.isDeleted(other_child)) {
+            surf::NoStats stats;
+            const level_t tail_level = label != surf::kTerminator ? level : level - 1;
+            if (other.matchLeaf(iter.key_, tail_level, other_child, stats)) {
+                other_key_id = other_child;
+            }
+        }
+        if constexpr (kDifference) {
+            if (other_key_id == kNotFound) fn(iter.key_, child);
+        } else {
+            if (other_key_id != kNotFound) fn(iter.key_, child, other_key_id);
+        }
+        return;
+    }
+
+    // a single key of other, searched for below the edge of this trie
+    position_t key_id = kNotFound;
+    if (!other.isDeleted(other_child)) {
+        other_iter.setKey(other_child, true, label);
+        key_id = searchFrom(other_iter.key_, level, child);
+    }
+    if constexpr (kDifference) {
+        enumerateEdge(iter, key_id, fn);
+    } else {
+        if (key_id != kNotFound) fn(other_iter.key_, key_id, other_child);
+    }
+}
+
+// Calls fn(key, key_id) for the live keys below the current edge of the deepest node of iter
+// except skip_key_id, leaving the node at that edge.
+template <class Fn>
+void Trie::enumerateEdge(Iter& iter, const position_t skip_key_id, Fn& fn) const {
+    const size_t num_frames = iter.frames_.size();
+    iter.moveToLeftMostKey();
+    for (;;) {
+        if (iter.key_id_ != skip_key_id && !isDeleted(iter.key_id_)) {
+            fn(iter.key_, iter.key_id_);
+        }
+        while (iter.frames_.size() > num_frames && !iter.moveToNextEdge(iter.frames_.back())) {
+            iter.frames_.pop_back();
+            iter.path_.pop_back();
+        }
+        if (iter.frames_.size() == num_frames) {
+            return;
+        }
+        iter.moveToLeftMostKey();
+    }
+}
+
+bool Trie::hasRankSelect() const {
+    return key_ranks_.getSize() != 0;
+}
+
+position_t Trie::rank(const std::string& key) const {
+    assert(hasRankSelect());
+    const Iter iter = seekLowerBound(key);
+    return iter.isValid() ? key_ranks_[iter.getKeyId()] : num_keys_;
+}
+
+Trie::Iter Trie::select(const position_t i) const {
+    assert(hasRankSelect());
+    Iter iter(this, "");
+    if (i < num_keys_) {
+        iter.moveToRank(i);
+    }
+    return iter;
+}
+
+position_t Trie::countRange(const std::string& left, const std::string& right) const {
+    return left < right ? rank(right) - rank(left) : 0;
+}
+
+position_t Trie::getKeyRank(const position_t key_id) const {
+    assert(hasRankSelect());
+    return key_ranks_[key_id];
+}
+
+position_t Trie::countPrefix(const std::string& prefix) const {
+    const auto range = getPrefixRange(prefix);
+    return range.second - range.first;
+}
+
+std::pair<position_t, position_t> Trie::getPrefixRange(const std::string& prefix) const {
+    assert(hasRankSelect());
+    if (num_keys_ == 0) {
+        return {0, 0};
+    }
+    Iter iter(this, "");
+    iter.pushNode(0);
+    position_t end = num_keys_;  // the rank following the keys below the current node
+    for (level_t level = 0;; ++level) {
+        Iter::Frame& frame = iter.frames_.back();
+        if (level == prefix.length()) {
+            return {node_ranks_[frame.node_num], end};
+        }
+        const label_t c = label_t(prefix[level]);
+        if (frame.is_dense) {
+            if (louds_dense_.nextLabel(frame.node_num, c) != c) {
+                return {0, 0};
+            }
+            frame.pos = c;
+        } else {
+            frame.pos = louds_sparse_.getFirstPos(frame.node_num);
+            while (louds_sparse_.getLabel(frame.pos) < c) {
+                frame.pos = louds_sparse_.getNextPosInNode(frame.pos);
+                if (frame.pos == kNotFound) {
+                    return {0, 0};
+                }
+            }
+            if (louds_sparse_.getLabel(frame.pos) != c) {
+                return {0, 0};
+            }
+        }
+        Iter::Frame next = frame;
+        if (iter.moveToNextEdge(next)) {
+            end = iter.getEdgeRank(next);
+        }
+
+        bool is_leaf = false;
+        const position_t child = frame.is_dense ? louds_dense_.moveToChild(frame.node_num, c, is_leaf)
+                                                : louds_sparse_.getChild(frame.pos, is_leaf);
+        if (is_leaf) {
+            // the key of the leaf starts with prefix if its tail starts with the rest
+            char buf[kMaxInlineTailBytes + 1];
+            const char* tail = getTail(child, buf);
+            for (++level; level < prefix.length(); ++level, ++tail) {
+                if (*tail != prefix[level]) {
+                    return {0, 0};
+                }
+            }
+            const position_t rank = key_ranks_[child];
+            return {rank, rank + 1};
+        }
+        iter.pushNode(child);
+    }
+}
+
+void Trie::setRanks(const std::vector<uint32_t>& key_ranks, const std::vector<uint32_t>& node_ranks) {
+    uint32_t bits = 0;
+    for (uint32_t max_rank = num_keys_ - 1; max_rank != 0 || bits == 0; max_rank >>= 1) {
+        bits += 1;
+    }
+    key_ranks_ = detail::CompactArray(key_ranks, bits);
+    node_ranks_ = detail::CompactArray(node_ranks, bits);
+}
+
+void Trie::Iter::operator++(int) {
+    moveToNextKey();
+    skipDeleted();
+    if (isValid() && !prefix_.empty() && key_.compare(0, prefix_.length(), prefix_) != 0) {
+        clear();
+    }
+}
+
+// Pushes the node at its first edge.
+void Trie::Iter::pushNode(const position_t node_num) {
+    const bool is_dense = frames_.size() < trie_->louds_dense_.getHeight();
+    position_t pos = 0;
+    if (is_dense) {
+        pos = trie_->louds_dense_.getPrefixKeyId(node_num) != kNotFound ? kPrefixKeyPos
+                                                                          : trie_->louds_dense_.nextLabel(node_num, 0);
+    } else {
+        pos = trie_->louds_sparse_.getFirstPos(node_num);
+    }
+    frames_.push_back({node_num, pos, is_dense});
+}
+
+bool Trie::Iter::moveToNextEdge(Frame& frame) const {
+    if (frame.is_dense) {
+        frame.pos = trie_->louds_dense_.nextLabel(frame.node_num, frame.pos == kPrefixKeyPos ? 0 : frame.pos + 1);
+        return frame.pos != surf::kFanout;
+    }
+    const position_t next = trie_->louds_sparse_.getNextPosInNode(frame.pos);
+    if (next == kNotFound) {
+        return false;
+    }
+    frame.pos = next;
+    return true;
+}
+
+// Moves frame to its first edge whose label is not less than label, from the current one.
+// Returns false if there is none.
+bool Trie::Iter::seekEdge(Frame& frame, const label_t label) const {
+    if (frame.is_dense) {
+        if (frame.pos == kPrefixKeyPos) {
+            if (label == surf::kTerminator) {
+                return true;
+            }
+            frame.pos = label;
+        }
+        frame.pos = trie_->louds_dense_.nextLabel(frame.node_num, std::max<position_t>(frame.pos, label));
+        return frame.pos != surf::kFanout;
+    }
+    while (trie_->louds_sparse_.getLabel(frame.pos) < label) {
+        const position_t next = trie_->louds_sparse_.getNextPosInNode(frame.pos);
+        if (next == kNotFound) {
+            return false;
+        }
+        frame.pos = next;
+    }
+    return true;
+}
+
+// Returns the label of the current edge of frame, the terminator for a prefix key.
+label_t Trie::Iter::getEdgeLabel(const Frame& frame) const {
+    if (frame.is_dense) {
+        return frame.pos == kPrefixKeyPos ? surf::kTerminator : label_t(frame.pos);
+    }
+    return trie_->louds_sparse_.getLabel(frame.pos);
+}
+
+// Returns the child node of the current edge of frame, or the key ID if it is a leaf.
+position_t Trie::Iter::getEdgeChild(const Frame& frame, bool& is_leaf) const {
+    if (frame.is_dense) {
+        if (frame.pos == kPrefixKeyPos) {
+            is_leaf = true;
+            return trie_->louds_dense_.getPrefixKeyId(frame.node_num);
+        }
+        return trie_->louds_dense_.moveToChild(frame.node_num, label_t(frame.pos), is_leaf);
+    }
+    return trie_->louds_sparse_.getChild(frame.pos, is_leaf);
+}
+
+// Follows the current edge of the deepest node. Returns true if it reaches a key, or pushes the
+// child node at its first edge and returns false.
+bool Trie::Iter::descend() {
+    const Frame& frame = frames_.back();
+    const label_t label = getEdgeLabel(frame);
+    bool is_leaf = false;
+    const position_t child = getEdgeChild(frame, is_leaf);
+    if (is_leaf) {
+        setKey(child, label != surf::kTerminator, label);
+        return true;
+    }
+    path_.push_back(char(label));
+    pushNode(child);
+    return false;
+}
+
+// Descends from the current edge of the deepest node to the smallest key below it.
+void Trie::Iter::moveToLeftMostKey() {
+    while (!descend()) {
+    }
+}
+
+// Returns the rank of the smallest key below the current edge of frame.
+position_t Trie::Iter::getEdgeRank(const Frame& frame) const {
+    bool is_leaf = false;
+    const position_t child = getEdgeChild(frame, is_leaf);
+    return is_leaf ? trie_->key_ranks_[child] : trie_->node_ranks_[child];
+}
+
+// Descends from the root, taking at each node the last edge whose smallest key has a rank not
+// greater than rank.
+void Trie::Iter::moveToRank(const position_t rank) {
+    pushNode(0);
+    do {
+        Frame& frame = frames_.back();
+        Frame next = frame;
+        while (moveToNextEdge(next) && getEdgeRank(next) <= rank) {
+            frame = next;
+        }
+    } while (!descend());
+    assert(trie_->key_ranks_[key_id_] == rank);
+}
+
+void Trie::Iter::moveToNextKey() {
+    while (!frames_.empty()) {
+        if (moveToNextEdge(frames_.back())) {
+            moveToLeftMostKey();
+            return;
+        }
+        frames_.pop_back();
+        if (!frames_.empty()) {
+            path_.pop_back();
+        }
+    }
+    clear();
+}
+
+void Trie::Iter::skipDeleted() {
+    while (isValid() && trie_->isDeleted(key_id_)) {
+        moveToNextKey();
+    }
+}
+
+void Trie::Iter::setKey(const position_t key_id, const bool has_label, const label_t label) {
+    key_ = path_;
+    if (has_label) {
+        key_.push_back(char(label));
+    }
+    char buf[kMaxInlineTailBytes + 1];
+    key_ += trie_->getTail(key_id, buf);
+    key_id_ = key_id;
+}
+
+void Trie::Iter::clear() {
+    frames_.clear();
+    path_.clear();
+    key_.clear();
+    key_id_ = kNotFound;
+}
+
+// Compares the rest of key with the tail at suf_pos.
+template <class Stats>
+bool Trie::matchTail(const std::string& key, level_t level, position_t suf_pos, Stats& stats) const {
+    const level_t start_level = level;
+    for (; level < key.length(); ++level) {
+        if (key[level] != suffixes_[suf_pos]) {
+            stats.onTailBytes(level - start_level + 1);
+            return false;
+        }
+        ++suf_pos;
+    }
+    stats.onTailBytes(level - start_level + 1);  // including the terminator
+    return suffixes_[suf_pos] == '\0';
+}
+
+// Compares the rest of key with the tail of the leaf key_id, checking the fingerprint first.
+template <class Stats>
+bool Trie::matchLeaf(const std::string& key, level_t level, position_t key_id, Stats& stats) const {
+    uint32_t entry = suffix_ptrs_[key_id];
+    if (inline_tail_bytes_ != 0) {
+        const bool is_inline = (entry & 1) != 0;
+        entry >>= 1;
+        if (is_inline) {
+            stats.onInlineTail();
+            if (key.length() > level + inline_tail_bytes_) {
+                return false;
+            }
+            for (; level < key.length(); ++level, entry >>= 8) {
+                if (key[level] == '\0' || label_t(key[level]) != (entry & 0xFF)) {
+                    return false;
+                }
+            }
+            return entry == 0;
+        }
+    }
+    if (fingerprint_bits_ != 0) {
+        const uint32_t mask = (1U << fingerprint_bits_) - 1;
+        if ((entry & mask) != (hashTail(key, level) & mask)) {
+            stats.onFingerprintReject();
+            return false;
+        }
+    }
+    return matchTail(key, level, entry >> fingerprint_bits_, stats);
+}
+
+const char* Trie::getTail(const position_t key_id, char (&buf)[kMaxInlineTailBytes + 1]) const {
+    uint32_t entry = suffix_ptrs_[key_id];
+    if (inline_tail_bytes_ != 0) {
+        const bool is_inline = (entry & 1) != 0;
+        entry >>= 1;
+        if (is_inline) {
+            for (uint32_t i = 0; i <= kMaxInlineTailBytes; ++i, entry >>= 8) {
+                buf[i] = char(entry & 0xFF);
+            }
+            return buf;
+        }
+    }
+    return &suffixes_[entry >> fingerprint_bits_];
+}
+
+// Hashes the tail of key from level, which is what the fingerprint of a leaf covers.
+uint32_t Trie::hashTail(const std::string& key, const level_t level) {
+    const size_t length = level < key.length() ? key.length() - level : 0;
+    return surf::Hash(key.data() + key.length() - length, length, 0x9747b28c);
+}
+
 namespace detail {
 
 CompactArray::CompactArray(const std::vector<uint32_t>& input, const uint32_t bits)
     : size_(static_cast<uint32_t>(input.size())),
       mask_((1U << bits) - 1),
       bits_(bits),
-      chunks_(size_ * bits_ / 32 + 1) {
+      num_chunks_(size_ * bits_ / 32 + 1),
+      chunks_(surf::makeArray<uint32_t>(num_chunks_)) {
     for (uint32_t i = 0; i < size_; ++i) {
         const uint32_t quo = i * bits_ / 32;
         const uint32_t mod = i * bits_ % 32;
@@ -330,25 +1666,127 @@ uint32_t CompactArray::getSize() const {
 }
 
 uint64_t CompactArray::getSizeIO() const {
-    return (sizeof(uint32_t) * 3) + detail::getVecSizeIO(chunks_);
+    return (sizeof(uint32_t) * 3) + detail::getArraySizeIO(chunks_, num_chunks_);
 }
 
 uint64_t CompactArray::getMemoryUsage() const {
-    return detail::getVecMemoryUsage(chunks_);
+    return sizeof(uint32_t) * num_chunks_;
 }
 
 void CompactArray::save(std::ostream& os) const {
     surf::saveValue(os, size_);
     surf::saveValue(os, mask_);
     surf::saveValue(os, bits_);
-    detail::saveVec(os, chunks_);
+    detail::saveArray(os, chunks_, num_chunks_);
 }
 
 void CompactArray::load(std::istream& is) {
     surf::loadValue(is, size_);
     surf::loadValue(is, mask_);
     surf::loadValue(is, bits_);
-    detail::loadVec(is, chunks_);
+    detail::loadArray(is, chunks_, num_chunks_);
+}
+
+size_t CompactArray::arenaBytes() const {
+    return surf::Arena::footprint<uint32_t>(num_chunks_);
+}
+
+void CompactArray::moveToArena(surf::Arena& arena) {
+    arena.relocate(chunks_, num_chunks_);
+}
+
+BloomFilter::BloomFilter(const std::vector<uint64_t>& hashes, const uint32_t bits_per_key)
+    : num_blocks_(std::max<size_t>((hashes.size() * bits_per_key + kBlockBits - 1) / kBlockBits, 1)),
+      num_probes_(std::min<uint32_t>(std::max<uint32_t>(uint32_t(bits_per_key * 0.69 + 0.5), 1), 16)),
+      blocks_(surf::makeArray<Block>(num_blocks_)) {
+    for (const uint64_t hash : hashes) {
+        Block& block = blocks_[((hash >> 32) * num_blocks_) >> 32];
+        uint32_t h = uint32_t(hash);
+        const uint32_t delta = (h >> 17) | (h << 15);  // double hashing as in LevelDB
+        for (uint32_t i = 0; i < num_probes_; ++i) {
+            const uint32_t bit = h % kBlockBits;
+            block.words[bit / 64] |= uint64_t(1) << (bit % 64);
+            h += delta;
+        }
+    }
+}
+
+bool BloomFilter::mayContain(const std::string& key) const {
+    if (num_blocks_ == 0) {
+        return true;
+    }
+    const uint64_t hash = hashKey(key);
+    const Block& block = blocks_[((hash >> 32) * num_blocks_) >> 32];
+    uint32_t h = uint32_t(hash);
+    const uint32_t delta = (h >> 17) | (h << 15);
+    for (uint32_t i = 0; i < num_probes_; ++i) {
+        const uint32_t bit = h % kBlockBits;
+        if ((block.words[bit / 64] & (uint64_t(1) << (bit % 64))) == 0) {
+            return false;
+        }
+        h += delta;
+    }
+    return true;
+}
+
+bool BloomFilter::isEmpty() const {
+    return num_blocks_ == 0;
+}
+
+uint64_t BloomFilter::getSizeIO() const {
+    return sizeof(num_probes_) + detail::getArraySizeIO(blocks_, num_blocks_);
+}
+
+uint64_t BloomFilter::getMemoryUsage() const {
+    return sizeof(Block) * num_blocks_;
+}
+
+void BloomFilter::save(std::ostream& os) const {
+    surf::saveValue(os, num_probes_);
+    detail::saveArray(os, blocks_, num_blocks_);
+}
+
+void BloomFilter::load(std::istream& is) {
+    surf::loadValue(is, num_probes_);
+    detail::loadArray(is, blocks_, num_blocks_);
+}
+
+size_t BloomFilter::arenaBytes() const {
+    return surf::Arena::footprint<Block>(num_blocks_);
+}
+
+void BloomFilter::moveToArena(surf::Arena& arena) {
+    arena.relocate(blocks_, num_blocks_);
+}
+
+// MurmurHash64A
+uint64_t BloomFilter::hashKey(const std::string& key) {
+    const uint64_t m = 0xc6a4a7935bd1e995ULL;
+    const int r = 47;
+    uint64_t h = 0x9e3779b97f4a7c15ULL ^ (key.size() * m);
+
+    const char* data = key.data();
+    const char* limit = data + (key.size() & ~size_t(7));
+    for (; data != limit; data += 8) {
+        uint64_t w;
+        memcpy(&w, data, sizeof(w));
+        w *= m;
+        w ^= w >> r;
+        w *= m;
+        h ^= w;
+        h *= m;
+    }
+    const size_t rest = key.size() & 7;
+    if (rest != 0) {
+        uint64_t w = 0;
+        memcpy(&w, data, rest);
+        h ^= w;
+        h *= m;
+    }
+    h ^= h >> r;
+    h *= m;
+    h ^= h >> r;
+    return h;
 }
 
 }  // namespace detail
@@ -0,0 +1,235 @@
+#pragma once
+
+#include "../fst.hpp"
+
+namespace fst {
+
+// Build parameters of Filter. The suffix bits stored per key trade space for the false positive
+// rate: hash bits filter point queries, while real bits (the key bytes following the truncated
+// trie) filter range queries as well. kMixed stores both.
+struct FilterConfig {
+    bool include_dense = surf::kIncludeDense;
+    uint32_t sparse_dense_ratio = surf::kSparseDenseRatio;
+    surf::SuffixType suffix_type = surf::kMixed;
+    level_t hash_suffix_len = 2;  // in bits
+    level_t real_suffix_len = 2;  // in bits
+};
+
+// An approximate membership filter for point and range queries (SuRF). Unlike Trie, it keeps
+// only the shortest prefixes that distinguish the keys (the truncated trie) followed by a few
+// suffix bits, so it has no false negatives but may have false positives. Keys must be sorted,
+// non-empty and must not contain '\0'.
+class Filter {
+  public:
+    Filter() = default;
+    Filter(const std::vector<std::string>& keys, const FilterConfig& config = FilterConfig());
+
+    Filter(Filter&&) = default;
+    Filter& operator=(Filter&&) = default;
+
+    ~Filter() = default;
+
+    // Returns false if key is certainly absent.
+    bool lookupKey(const std::string& key) const;
+    // Returns false if no key is certainly within the range.
+    bool lookupRange(const std::string& left_key, const bool left_inclusive, const std::string& right_key,
+                     const bool right_inclusive) const;
+
+    uint64_t getSizeIO() const;
+    uint64_t getMemoryUsage() const;
+
+    level_t getHeight() const;
+    level_t getSparseStartLevel() const;
+
+    uint64_t getNumKeys() const;
+
+    void save(std::ostream& os) const;
+    void load(std::istream& is);
+
+  private:
+    class Iter;
+
+    surf::LoudsDense louds_dense_;
+    surf::LoudsSparse louds_sparse_;
+    uint64_t num_keys_ = 0;
+};
+
+// A cursor over the truncated keys that combines the iterators of both encodings, as in SuRF.
+// If the dense iterator stops at its last level, the sparse one continues from the node sent out.
+class Filter::Iter {
+  public:
+    explicit Iter(const Filter* filter)
+        : filter_(filter), dense_iter_(&filter->louds_dense_), sparse_iter_(&filter->louds_sparse_) {}
+
+    bool isValid() const;
+    // Compares the truncated key (plus its real suffix bits) with key; kCouldBePositive if equal
+    int compare(const std::string& key) const;
+
+    void moveToFirst();
+    // Moves to the smallest truncated key that may be greater than (or equal to) key
+    void moveToKeyGreaterThan(const std::string& key, const bool inclusive);
+
+  private:
+    bool hasDense() const {
+        return filter_->louds_dense_.getHeight() != 0;
+    }
+    void passToSparse();
+    void incrementDenseIter();
+
+    const Filter* filter_;
+    surf::LoudsDense::Iter dense_iter_;
+    surf::LoudsSparse::Iter sparse_iter_;
+};
+
+Filter::Filter(const std::vector<std::string>& keys, const FilterConfig& config) {
+    assert(config.suffix_type == surf::kNone || config.hash_suffix_len + config.real_suffix_len > 0);
+    surf::SuRFBuilder builder(config.include_dense, config.sparse_dense_ratio, config.suffix_type,
+                              config.hash_suffix_len, config.real_suffix_len);
+    builder.build(keys);
+    louds_dense_ = surf::LoudsDense(&builder);
+    louds_sparse_ = surf::LoudsSparse(&builder);
+
+    num_keys_ = 0;
+    for (level_t level = 0; level < louds_sparse_.getHeight(); ++level) {
+        num_keys_ += builder.getSuffixCounts()[level];
+    }
+}
+
+bool Filter::lookupKey(const std::string& key) const {
+    position_t connect_node_num = kNotFound;  // the root (0) if there are no dense levels
+    if (!louds_dense_.lookupKey(key, connect_node_num)) {
+        return false;
+    }
+    if (connect_node_num != kNotFound) {
+        return louds_sparse_.lookupKey(key, connect_node_num);
+    }
+    return true;
+}
+
+bool Filter::lookupRange(const std::string& left_key, const bool left_inclusive, const std::string& right_key,
+                         const bool right_inclusive) const {
+    Iter iter(this);
+    iter.moveToKeyGreaterThan(left_key, left_inclusive);
+    if (!iter.isValid()) {
+        return false;
+    }
+    const int compare = iter.compare(right_key);
+    if (compare == surf::kCouldBePositive) {
+        return true;
+    }
+    return right_inclusive ? compare <= 0 : compare < 0;
+}
+
+uint64_t Filter::getSizeIO() const {
+    return louds_dense_.serializedSize() + louds_sparse_.serializedSize() + sizeof(num_keys_);
+}
+
+uint64_t Filter::getMemoryUsage() const {
+    // the LOUDS structures are held in place and thus already counted in sizeof(Filter)
+    return sizeof(Filter) + (louds_dense_.getMemoryUsage() - sizeof(louds_dense_)) +
+           (louds_sparse_.getMemoryUsage() - sizeof(louds_sparse_));
+}
+
+level_t Filter::getHeight() const {
+    return louds_sparse_.getHeight();
+}
+
+level_t Filter::getSparseStartLevel() const {
+    return louds_sparse_.getStartLevel();
+}
+
+uint64_t Filter::getNumKeys() const {
+    return num_keys_;
+}
+
+void Filter::save(std::ostream& os) const {
+    louds_dense_.save(os);
+    louds_sparse_.save(os);
+    surf::saveValue(os, num_keys_);
+}
+
+void Filter::load(std::istream& is) {
+    louds_dense_.load(is);
+    louds_sparse_.load(is);
+    surf::loadValue(is, num_keys_);
+}
+
+//============================================================================
+
+bool Filter::Iter::isValid() const {
+    if (!hasDense()) {
+        return sparse_iter_.isValid();
+    }
+    return dense_iter_.isValid() && (dense_iter_.isComplete() || sparse_iter_.isValid());
+}
+
+int Filter::Iter::compare(const std::string& key) const {
+    assert(isValid());
+    if (hasDense()) {
+        const int dense_compare = dense_iter_.compare(key);
+        if (dense_iter_.isComplete() || dense_compare != 0) {
+            return dense_compare;
+        }
+    }
+    return sparse_iter_.compare(key);
+}
+
+void Filter::Iter::moveToFirst() {
+    dense_iter_.clear();
+    sparse_iter_.clear();
+    if (!hasDense()) {
+        sparse_iter_.setStartNodeNum(0);
+        sparse_iter_.moveToLeftMostKey();
+        return;
+    }
+    dense_iter_.setToFirstLabelInRoot();
+    dense_iter_.moveToLeftMostKey();
+    if (!dense_iter_.isMoveLeftComplete()) {
+        passToSparse();
+        sparse_iter_.moveToLeftMostKey();
+    }
+}
+
+void Filter::Iter::moveToKeyGreaterThan(const std::string& key, const bool inclusive) {
+    if (key.empty()) {  // every key is greater, and the walk below needs a label
+        return moveToFirst();
+    }
+    dense_iter_.clear();
+    sparse_iter_.clear();
+    if (!hasDense()) {
+        sparse_iter_.setStartNodeNum(0);
+        filter_->louds_sparse_.moveToKeyGreaterThan(key, inclusive, sparse_iter_);
+        return;
+    }
+
+    filter_->louds_dense_.moveToKeyGreaterThan(key, inclusive, dense_iter_);
+    if (!dense_iter_.isValid() || dense_iter_.isComplete()) {
+        return;
+    }
+    if (!dense_iter_.isSearchComplete()) {
+        passToSparse();
+        filter_->louds_sparse_.moveToKeyGreaterThan(key, inclusive, sparse_iter_);
+        if (!sparse_iter_.isValid()) {
+            incrementDenseIter();
+        }
+    } else if (!dense_iter_.isMoveLeftComplete()) {
+        passToSparse();
+        sparse_iter_.moveToLeftMostKey();
+    }
+}
+
+void Filter::Iter::passToSparse() {
+    sparse_iter_.clear();
+    sparse_iter_.setStartNodeNum(dense_iter_.getSendOutNodeNum());
+}
+
+void Filter::Iter::incrementDenseIter() {
+    dense_iter_++;
+    if (!dense_iter_.isValid() || dense_iter_.isMoveLeftComplete()) {
+        return;
+    }
+    passToSparse();
+    sparse_iter_.moveToLeftMostKey();
+}
+
+}  // namespace fst
@@ -0,0 +1,205 @@
+#pragma once
+
+#include <atomic>
+#include <cstring>
+#include <memory>
+
+#include "../fst.hpp"
+
+namespace fst {
+
+// A fixed-size set-associative cache of (key -> key_id) in front of Trie::exactSearch.
+// Each slot is protected by a sequence counter (seqlock), so lookups never block and are
+// safe for any number of concurrent readers; a writer that loses a race just skips the fill.
+// Negative results are cached as well. Keys longer than kMaxKeyLength bypass the cache.
+// The cache refers to the given trie and must be cleared if the trie is modified or reloaded.
+class HotKeyCache {
+  public:
+    static constexpr uint32_t kWays = 4;
+    static constexpr uint32_t kKeyWords = 5;
+    static constexpr uint32_t kMaxKeyLength = kKeyWords * 8;
+    static constexpr uint64_t kDefaultCapacity = uint64_t(1) << 16;
+
+    explicit HotKeyCache(const Trie& trie, const uint64_t capacity = kDefaultCapacity);
+
+    ~HotKeyCache() = default;
+
+    position_t exactSearch(const std::string& key) const;
+
+    uint64_t getCapacity() const;
+    uint64_t getHits() const;
+    uint64_t getMisses() const;
+    uint64_t getMemoryUsage() const;
+
+    void resetCounters();
+    void clear();
+
+  private:
+    // One slot fills one cache line: sequence, tag, value and up to kMaxKeyLength key bytes.
+    struct alignas(64) Slot {
+        std::atomic<uint64_t> seq{0};  // odd while being written
+        std::atomic<uint64_t> tag{0};  // 0 means empty
+        std::atomic<uint64_t> value{0};
+        std::atomic<uint64_t> words[kKeyWords] = {};
+    };
+
+    // Counters are striped per thread to avoid bouncing one cache line between readers.
+    struct alignas(64) Counter {
+        std::atomic<uint64_t> hits{0};
+        std::atomic<uint64_t> misses{0};
+    };
+    static constexpr uint32_t kNumStripes = 64;
+
+    static uint64_t hashKey(const std::string& key);
+    static uint32_t getStripe();
+
+    bool find(const Slot* set, const uint64_t tag, const uint64_t* words, position_t& key_id) const;
+    void fill(Slot* set, const uint64_t tag, const uint64_t* words, const position_t key_id) const;
+
+  private:
+    const Trie* trie_ = nullptr;
+    uint64_t num_sets_ = 0;
+    std::unique_ptr<Slot[]> slots_;
+    std::unique_ptr<Counter[]> counters_;
+};
+
+HotKeyCache::HotKeyCache(const Trie& trie, const uint64_t capacity) : trie_(&trie) {
+    num_sets_ = 1;
+    while (num_sets_ * kWays < capacity) {
+        num_sets_ <<= 1;
+    }
+    slots_ = std::make_unique<Slot[]>(num_sets_ * kWays);
+    counters_ = std::make_unique<Counter[]>(kNumStripes);
+}
+
+position_t HotKeyCache::exactSearch(const std::string& key) const {
+    if (key.length() > kMaxKeyLength) {
+        return trie_->exactSearch(key);
+    }
+
+    uint64_t words[kKeyWords] = {};
+    memcpy(words, key.data(), key.length());
+
+    const uint64_t hash = hashKey(key);
+    const uint64_t tag = (hash & ~uint64_t(0xFF)) | (key.length() + 1);
+    Slot* set = &slots_[(hash & (num_sets_ - 1)) * kWays];
+
+    Counter& counter = counters_[getStripe()];
+    position_t key_id = kNotFound;
+    if (find(set, tag, words, key_id)) {
+        counter.hits.fetch_add(1, std::memory_order_relaxed);
+        return key_id;
+    }
+    counter.misses.fetch_add(1, std::memory_order_relaxed);
+
+    key_id = trie_->exactSearch(key);
+    fill(set, tag, words, key_id);
+    return key_id;
+}
+
+uint64_t HotKeyCache::getCapacity() const {
+    return num_sets_ * kWays;
+}
+
+uint64_t HotKeyCache::getHits() const {
+    uint64_t hits = 0;
+    for (uint32_t i = 0; i < kNumStripes; ++i) {
+        hits += counters_[i].hits.load(std::memory_order_relaxed);
+    }
+    return hits;
+}
+
+uint64_t HotKeyCache::getMisses() const {
+    uint64_t misses = 0;
+    for (uint32_t i = 0; i < kNumStripes; ++i) {
+        misses += counters_[i].misses.load(std::memory_order_relaxed);
+    }
+    return misses;
+}
+
+uint64_t HotKeyCache::getMemoryUsage() const {
+    return sizeof(HotKeyCache) + sizeof(Slot) * getCapacity() + sizeof(Counter) * kNumStripes;
+}
+
+void HotKeyCache::resetCounters() {
+    for (uint32_t i = 0; i < kNumStripes; ++i) {
+        counters_[i].hits.store(0, std::memory_order_relaxed);
+        counters_[i].misses.store(0, std::memory_order_relaxed);
+    }
+}
+
+// Not safe against concurrent lookups.
+void HotKeyCache::clear() {
+    for (uint64_t i = 0; i < getCapacity(); ++i) {
+        slots_[i].tag.store(0, std::memory_order_relaxed);
+    }
+}
+
+uint64_t HotKeyCache::hashKey(const std::string& key) {
+    // FNV-1a followed by the MurmurHash3 finalizer
+    uint64_t h = 0xcbf29ce484222325ULL;
+    for (const char c : key) {
+        h ^= static_cast<uint8_t>(c);
+        h *= 0x100000001b3ULL;
+    }
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+uint32_t HotKeyCache::getStripe() {
+    static std::atomic<uint32_t> num_threads{0};
+    static thread_local const uint32_t stripe = num_threads.fetch_add(1, std::memory_order_relaxed) % kNumStripes;
+    return stripe;
+}
+
+bool HotKeyCache::find(const Slot* set, const uint64_t tag, const uint64_t* words, position_t& key_id) const {
+    for (uint32_t way = 0; way < kWays; ++way) {
+        const Slot& slot = set[way];
+        const uint64_t seq = slot.seq.load(std::memory_order_acquire);
+        if ((seq & 1) || slot.tag.load(std::memory_order_relaxed) != tag) {
+            continue;
+        }
+        const uint64_t value = slot.value.load(std::memory_order_relaxed);
+        bool match = true;
+        for (uint32_t i = 0; i < kKeyWords; ++i) {
+            match &= (slot.words[i].load(std::memory_order_relaxed) == words[i]);
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (match && slot.seq.load(std::memory_order_relaxed) == seq) {
+            key_id = static_cast<position_t>(value);
+            return true;
+        }
+    }
+    return false;
+}
+
+void HotKeyCache::fill(Slot* set, const uint64_t tag, const uint64_t* words, const position_t key_id) const {
+    // Prefer an empty way; otherwise evict a pseudo-random one.
+    static thread_local uint32_t victim = 0;
+    uint32_t way = victim++ % kWays;
+    for (uint32_t i = 0; i < kWays; ++i) {
+        if (set[i].tag.load(std::memory_order_relaxed) == 0) {
+            way = i;
+            break;
+        }
+    }
+
+    Slot& slot = set[way];
+    uint64_t seq = slot.seq.load(std::memory_order_relaxed);
+    if ((seq & 1) || !slot.seq.compare_exchange_strong(seq, seq + 1, std::memory_order_acquire)) {
+        return;  // another writer owns the slot
+    }
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.tag.store(tag, std::memory_order_relaxed);
+    slot.value.store(key_id, std::memory_order_relaxed);
+    for (uint32_t i = 0; i < kKeyWords; ++i) {
+        slot.words[i].store(words[i], std::memory_order_relaxed);
+    }
+    slot.seq.store(seq + 2, std::memory_order_release);
+}
+
+}  // namespace fst
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <queue>
+
+#include "../fst.hpp"
+
+namespace fst {
+
+struct MergeResult {
+    Trie trie;
+    // key_id_maps[j][key_id] is the key ID in trie of the key of key_id in the j-th input, or
+    // kNotFound if that key is deleted.
+    std::vector<std::vector<position_t>> key_id_maps;
+};
+
+// Merges the live keys of tries into one trie built with config, in a single pass. The inputs
+// are walked in lockstep by their ordered iterators, the smallest key first (from a heap over
+// the inputs), and each distinct key is fed to a TrieBuilder, so no key list is materialized.
+// Besides the output, the memory holds the tails (see TrieBuilder) and the key ID maps.
+MergeResult mergeTries(const std::vector<const Trie*>& tries, const Config& config = Config()) {
+    MergeResult result;
+    result.key_id_maps.resize(tries.size());
+    std::vector<Trie::Iter> iters;
+    iters.reserve(tries.size());
+    for (size_t j = 0; j < tries.size(); ++j) {
+        result.key_id_maps[j].assign(tries[j]->getNumKeyIds(), kNotFound);
+        iters.push_back(tries[j]->begin());
+    }
+
+    // the input at the smallest key on top; ties go to the first input
+    auto greater = [&](const size_t x, const size_t y) {
+        const int compare = iters[x].getKey().compare(iters[y].getKey());
+        return compare != 0 ? compare > 0 : x > y;
+    };
+    std::priority_queue<size_t, std::vector<size_t>, decltype(greater)> heap(greater);
+    for (size_t j = 0; j < tries.size(); ++j) {
+        if (iters[j].isValid()) {
+            heap.push(j);
+        }
+    }
+
+    // The maps first hold the output ranks, which become key IDs once the trie is built.
+    TrieBuilder builder(config);
+    position_t rank = 0;
+    std::string key;
+    while (!heap.empty()) {
+        key = iters[heap.top()].getKey();
+        do {
+            const size_t j = heap.top();
+            heap.pop();
+            result.key_id_maps[j][iters[j].getKeyId()] = rank;
+            iters[j]++;
+            if (iters[j].isValid()) {
+                heap.push(j);
+            }
+        } while (!heap.empty() && iters[heap.top()].getKey() == key);
+        builder.add(key);
+        ++rank;
+    }
+
+    std::vector<position_t> key_ids;
+    result.trie = builder.build(&key_ids);
+    for (auto& key_id_map : result.key_id_maps) {
+        for (position_t& key_id : key_id_map) {
+            if (key_id != kNotFound) {
+                key_id = key_ids[key_id];
+            }
+        }
+    }
+    return result;
+}
+
+}  // namespace fst
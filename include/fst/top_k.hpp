@@ -0,0 +1,161 @@
+#pragma once
+
+#include <queue>
+
+#include "../fst.hpp"
+
+namespace fst {
+
+// Top-k weighted completion over a Trie built with Config::rank_select. The keys starting with a
+// prefix have consecutive ranks, so the weights are laid out in rank order and topK runs a
+// best-first search over rank ranges: it pops the heaviest key of a range and pushes the two
+// ranges beside it. The range maximum is the maximum of the full blocks of kBlockSize weights,
+// taken from a sparse table over the block maxima, and a scan of the partial blocks at both ends.
+// A query takes O(k log k) range maxima plus k Trie::select calls, i.e., O(k * depth) nodes.
+// Deleted keys (Trie::erase) are skipped. The completer refers to the given trie and must be
+// rebuilt if the trie is rebuilt or reloaded.
+class TopKCompleter {
+  public:
+    static constexpr position_t kBlockSize = 64;
+
+    struct Completion {
+        std::string key;
+        position_t key_id;
+        uint32_t weight;
+    };
+
+    // weights[key_id] is the weight of the key of key_id.
+    TopKCompleter(const Trie& trie, const std::vector<uint32_t>& weights);
+
+    ~TopKCompleter() = default;
+
+    // Returns up to k keys starting with prefix, the heaviest first; ties go to the smaller key.
+    std::vector<Completion> topK(const std::string& prefix, size_t k) const;
+
+    uint64_t getMemoryUsage() const;
+
+  private:
+    // Returns the rank of the heaviest key in [first, last), which must not be empty.
+    position_t getMaxRank(position_t first, position_t last) const;
+    position_t scanMaxRank(position_t first, position_t last) const;
+    position_t heavier(position_t x, position_t y) const;
+
+  private:
+    const Trie* trie_ = nullptr;
+    std::vector<uint32_t> weights_;  // in rank order
+    // sparse_table_[j][b] is the rank of the heaviest key in blocks [b, b + 2^j)
+    std::vector<std::vector<position_t>> sparse_table_;
+};
+
+TopKCompleter::TopKCompleter(const Trie& trie, const std::vector<uint32_t>& weights) : trie_(&trie) {
+    assert(trie.hasRankSelect());
+    assert(weights.size() == trie.getNumKeyIds());
+
+    const position_t num_keys = position_t(trie.getNumKeyIds());
+    weights_.resize(num_keys);
+    for (position_t key_id = 0; key_id < num_keys; ++key_id) {
+        weights_[trie.getKeyRank(key_id)] = weights[key_id];
+    }
+
+    const position_t num_blocks = (num_keys + kBlockSize - 1) / kBlockSize;
+    std::vector<position_t> block_max(num_blocks);
+    for (position_t b = 0; b < num_blocks; ++b) {
+        block_max[b] = scanMaxRank(b * kBlockSize, std::min((b + 1) * kBlockSize, num_keys));
+    }
+    sparse_table_.push_back(std::move(block_max));
+    for (position_t width = 2; width <= num_blocks; width *= 2) {
+        const std::vector<position_t>& prev = sparse_table_.back();
+        std::vector<position_t> curr(num_blocks - width + 1);
+        for (position_t b = 0; b < curr.size(); ++b) {
+            curr[b] = heavier(prev[b], prev[b + width / 2]);
+        }
+        sparse_table_.push_back(std::move(curr));
+    }
+}
+
+std::vector<TopKCompleter::Completion> TopKCompleter::topK(const std::string& prefix, const size_t k) const {
+    std::vector<Completion> completions;
+    const auto range = trie_->getPrefixRange(prefix);
+    if (range.first == range.second || k == 0) {
+        return completions;
+    }
+
+    struct Candidate {
+        position_t rank;
+        position_t first;
+        position_t last;
+    };
+    auto lighter = [&](const Candidate& x, const Candidate& y) { return heavier(x.rank, y.rank) == y.rank; };
+    std::priority_queue<Candidate, std::vector<Candidate>, decltype(lighter)> heap(lighter);
+
+    heap.push({getMaxRank(range.first, range.second), range.first, range.second});
+    while (!heap.empty() && completions.size() < k) {
+        const Candidate top = heap.top();
+        heap.pop();
+
+        const auto iter = trie_->select(top.rank);
+        if (!trie_->isDeleted(iter.getKeyId())) {
+            completions.push_back({iter.getKey(), iter.getKeyId(), weights_[top.rank]});
+        }
+
+        if (top.first < top.rank) {
+            heap.push({getMaxRank(top.first, top.rank), top.first, top.rank});
+        }
+        if (top.rank + 1 < top.last) {
+            heap.push({getMaxRank(top.rank + 1, top.last), top.rank + 1, top.last});
+        }
+    }
+    return completions;
+}
+
+uint64_t TopKCompleter::getMemoryUsage() const {
+    uint64_t bytes = sizeof(TopKCompleter) + sizeof(uint32_t) * weights_.size();
+    for (const auto& level : sparse_table_) {
+        bytes += sizeof(std::vector<position_t>) + sizeof(position_t) * level.size();
+    }
+    return bytes;
+}
+
+position_t TopKCompleter::getMaxRank(const position_t first, const position_t last) const {
+    assert(first < last);
+    const position_t first_block = (first + kBlockSize - 1) / kBlockSize;  // the first full block
+    const position_t last_block = last / kBlockSize;  // past the last full block
+    if (first_block >= last_block) {
+        return scanMaxRank(first, last);
+    }
+
+    position_t max_rank = kNotFound;
+    if (first < first_block * kBlockSize) {
+        max_rank = scanMaxRank(first, first_block * kBlockSize);
+    }
+    position_t level = 0;
+    while ((position_t(2) << level) <= last_block - first_block) {
+        ++level;
+    }
+    const position_t blocks_max = heavier(sparse_table_[level][first_block],
+                                          sparse_table_[level][last_block - (position_t(1) << level)]);
+    max_rank = max_rank == kNotFound ? blocks_max : heavier(max_rank, blocks_max);
+    if (last_block * kBlockSize < last) {
+        max_rank = heavier(max_rank, scanMaxRank(last_block * kBlockSize, last));
+    }
+    return max_rank;
+}
+
+position_t TopKCompleter::scanMaxRank(const position_t first, const position_t last) const {
+    position_t max_rank = first;
+    for (position_t rank = first + 1; rank < last; ++rank) {
+        if (weights_[rank] > weights_[max_rank]) {
+            max_rank = rank;
+        }
+    }
+    return max_rank;
+}
+
+position_t TopKCompleter::heavier(const position_t x, const position_t y) const {
+    if (weights_[x] != weights_[y]) {
+        return weights_[x] > weights_[y] ? x : y;
+    }
+    return std::min(x, y);
+}
+
+}  // namespace fst
@@ -0,0 +1,219 @@
+#pragma once
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <thread>
+
+#include "../fst.hpp"
+
+namespace fst {
+
+// A key set over an immutable Trie that takes inserts and erases. Updates go to a sorted write
+// buffer that is queried before the trie. Once the buffer holds merge_threshold updates (or on
+// startMerge), a background thread builds the next trie by streaming the keys of the current
+// one through a TrieBuilder merged with the buffer, so neither the old nor the new key set is
+// materialized. Meanwhile the buffer is frozen and still queried, and new updates go to a fresh
+// one. The next trie and the emptied buffer replace the old ones in one step under the lock,
+// so a reader sees either version but never a mix. If the fresh buffer has reached
+// merge_threshold by then, the same thread goes on to merge it. Key IDs change across versions, so only
+// membership is exposed. Keys must be non-empty and must not contain '\0' (see Trie::Iter).
+class UpdatableTrie {
+  public:
+    static constexpr size_t kDefaultMergeThreshold = size_t(1) << 16;
+
+    explicit UpdatableTrie(const Config& config = Config(), const size_t merge_threshold = kDefaultMergeThreshold);
+    // keys must be sorted.
+    UpdatableTrie(const std::vector<std::string>& keys, const Config& config = Config(),
+                  const size_t merge_threshold = kDefaultMergeThreshold);
+
+    // Waits for the running merge, if any, without merging the rest of the buffer.
+    ~UpdatableTrie();
+
+    void insert(const std::string& key);
+    void erase(const std::string& key);
+    bool contains(const std::string& key) const;
+
+    // Starts merging the buffered updates in the background. Returns false if a merge is
+    // already running or there is nothing to merge.
+    bool startMerge();
+    // Merges the buffered updates and waits until they are in the trie. Updates that other
+    // threads make meanwhile are merged as well, so this returns once the buffer is seen empty.
+    void waitForMerge();
+
+    // Returns the current static version, which does not reflect the buffered updates.
+    std::shared_ptr<const Trie> getTrie() const;
+    size_t getNumBufferedUpdates() const;
+
+  private:
+    // key -> true if inserted, false if erased
+    using Buffer = std::map<std::string, bool>;
+
+    void update(const std::string& key, bool is_insert);
+    Trie merge(const Trie& trie, const Buffer& buffer) const;
+    void joinMergeThread();
+
+  private:
+    const Config config_;
+    const size_t merge_threshold_;
+
+    mutable std::shared_mutex mutex_;  // guards trie_, buffer_ and frozen_buffer_
+    std::shared_ptr<const Trie> trie_;
+    Buffer buffer_;
+    std::shared_ptr<const Buffer> frozen_buffer_;  // null unless a merge is running
+
+    std::mutex merge_mutex_;  // guards merge_thread_
+    std::thread merge_thread_;
+};
+
+UpdatableTrie::UpdatableTrie(const Config& config, const size_t merge_threshold)
+    : config_(config), merge_threshold_(merge_threshold), trie_(std::make_shared<const Trie>()) {}
+
+UpdatableTrie::UpdatableTrie(const std::vector<std::string>& keys, const Config& config, const size_t merge_threshold)
+    : config_(config),
+      merge_threshold_(merge_threshold),
+      trie_(std::make_shared<const Trie>(Trie(keys, config))) {}
+
+UpdatableTrie::~UpdatableTrie() {
+    joinMergeThread();
+}
+
+void UpdatableTrie::insert(const std::string& key) {
+    update(key, true);
+}
+
+void UpdatableTrie::erase(const std::string& key) {
+    update(key, false);
+}
+
+bool UpdatableTrie::contains(const std::string& key) const {
+    std::shared_ptr<const Trie> trie;
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        auto it = buffer_.find(key);
+        if (it != buffer_.end()) {
+            return it->second;
+        }
+        if (frozen_buffer_) {
+            it = frozen_buffer_->find(key);
+            if (it != frozen_buffer_->end()) {
+                return it->second;
+            }
+        }
+        trie = trie_;
+    }
+    // an empty Trie has no LOUDS levels to search
+    return trie->getNumKeys() != 0 && trie->exactSearch(key) != kNotFound;
+}
+
+bool UpdatableTrie::startMerge() {
+    std::lock_guard<std::mutex> merge_lock(merge_mutex_);
+
+    std::shared_ptr<const Trie> trie;
+    std::shared_ptr<const Buffer> frozen_buffer;
+    {
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+        if (frozen_buffer_ || buffer_.empty()) {
+            return false;
+        }
+        frozen_buffer_ = std::make_shared<const Buffer>(std::move(buffer_));
+        buffer_.clear();
+        trie = trie_;
+        frozen_buffer = frozen_buffer_;
+    }
+
+    if (merge_thread_.joinable()) {  // the previous merge, which has published its trie
+        merge_thread_.join();
+    }
+    merge_thread_ = std::thread([this, trie, frozen_buffer]() mutable {
+        for (;;) {
+            auto next_trie = std::make_shared<const Trie>(merge(*trie, *frozen_buffer));
+            std::unique_lock<std::shared_mutex> lock(mutex_);
+            trie_ = std::move(next_trie);
+            if (buffer_.size() < merge_threshold_) {
+                frozen_buffer_.reset();
+                return;
+            }
+            // the updates that came during the merge filled the buffer, and update() could not
+            // start a merge meanwhile
+            frozen_buffer_ = std::make_shared<const Buffer>(std::move(buffer_));
+            buffer_.clear();
+            trie = trie_;
+            frozen_buffer = frozen_buffer_;
+        }
+    });
+    return true;
+}
+
+void UpdatableTrie::waitForMerge() {
+    for (;;) {
+        joinMergeThread();
+        // startMerge fails if the buffer is empty, or if another thread has started a merge,
+        // which the next round waits for
+        if (!startMerge() && getNumBufferedUpdates() == 0) {
+            return;
+        }
+    }
+}
+
+void UpdatableTrie::joinMergeThread() {
+    std::lock_guard<std::mutex> merge_lock(merge_mutex_);
+    if (merge_thread_.joinable()) {
+        merge_thread_.join();
+    }
+}
+
+std::shared_ptr<const Trie> UpdatableTrie::getTrie() const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    return trie_;
+}
+
+size_t UpdatableTrie::getNumBufferedUpdates() const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    return buffer_.size() + (frozen_buffer_ ? frozen_buffer_->size() : 0);
+}
+
+void UpdatableTrie::update(const std::string& key, const bool is_insert) {
+    assert(!key.empty());
+    size_t buffer_size = 0;
+    {
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+        buffer_[key] = is_insert;
+        buffer_size = buffer_.size();
+    }
+    if (buffer_size >= merge_threshold_) {
+        startMerge();
+    }
+}
+
+Trie UpdatableTrie::merge(const Trie& trie, const Buffer& buffer) const {
+    TrieBuilder builder(config_);
+    auto it = buffer.begin();
+    if (trie.getNumKeys() != 0) {
+        for (auto iter = trie.begin(); iter.isValid(); iter++) {
+            const std::string& key = iter.getKey();
+            for (; it != buffer.end() && it->first < key; ++it) {
+                if (it->second) {
+                    builder.add(it->first);
+                }
+            }
+            if (it != buffer.end() && it->first == key) {
+                if (it->second) {
+                    builder.add(key);
+                }
+                ++it;
+            } else {
+                builder.add(key);
+            }
+        }
+    }
+    for (; it != buffer.end(); ++it) {
+        if (it->second) {
+            builder.add(it->first);
+        }
+    }
+    return builder.build();
+}
+
+}  // namespace fst
@@ -0,0 +1,144 @@
+//  Allocation of the large arrays (bitvectors, rank/select LUTs, labels and tails).
+//  With kAllocHugePage, arrays of at least kHugePageSize bytes are placed on 2 MiB-aligned
+//  anonymous mappings advised with MADV_HUGEPAGE (transparent huge pages). With kAllocHugeTLB,
+//  MAP_HUGETLB (pre-reserved hugetlbfs pages) is tried first, falling back to kAllocHugePage.
+//  An Arena packs the arrays of a whole trie into one such allocation.
+//
+#ifndef ALLOCATOR_H_
+#define ALLOCATOR_H_
+
+#include <assert.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/mman.h>
+
+#include <atomic>
+#include <memory>
+#include <type_traits>
+
+namespace surf {
+
+enum AllocPolicy { kAllocDefault = 0, kAllocHugePage = 1, kAllocHugeTLB = 2 };
+
+static const size_t kHugePageSize = size_t(1) << 21;
+
+inline std::atomic<int>& allocPolicy() {
+    static std::atomic<int> policy{kAllocDefault};
+    return policy;
+}
+
+// The policy is process-wide and applies to arrays allocated after the call.
+inline void setAllocPolicy(const AllocPolicy policy) {
+    allocPolicy().store(policy, std::memory_order_relaxed);
+}
+
+inline AllocPolicy getAllocPolicy() {
+    return static_cast<AllocPolicy>(allocPolicy().load(std::memory_order_relaxed));
+}
+
+struct ArrayDeleter {
+    size_t mapped_bytes = 0;  // non-zero if the array is on its own mapping
+    bool borrowed = false;  // true if the array lives in an Arena
+
+    template <typename T>
+    void operator()(T* ptr) const {
+        if (borrowed)
+            return;
+        else if (mapped_bytes != 0)
+            munmap(ptr, mapped_bytes);
+        else
+            delete[] ptr;
+    }
+};
+
+template <typename T>
+using array_ptr = std::unique_ptr<T[], ArrayDeleter>;
+
+// Returns a 2 MiB-aligned mapping of bytes (a multiple of kHugePageSize), or nullptr.
+inline void* mapHugePages(const size_t bytes, const AllocPolicy policy) {
+#ifdef MAP_HUGETLB
+    if (policy == kAllocHugeTLB) {
+        void* ptr = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (ptr != MAP_FAILED) return ptr;
+    }
+#endif
+    // over-map by one huge page and trim both ends to get the alignment
+    const size_t map_bytes = bytes + kHugePageSize;
+    void* ptr = mmap(nullptr, map_bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (ptr == MAP_FAILED) return nullptr;
+
+    char* head = static_cast<char*>(ptr);
+    char* aligned = reinterpret_cast<char*>((reinterpret_cast<uintptr_t>(head) + kHugePageSize - 1) &
+                                            ~uintptr_t(kHugePageSize - 1));
+    if (aligned != head) munmap(head, aligned - head);
+    const size_t tail_bytes = (head + map_bytes) - (aligned + bytes);
+    if (tail_bytes != 0) munmap(aligned + bytes, tail_bytes);
+#ifdef MADV_HUGEPAGE
+    madvise(aligned, bytes, MADV_HUGEPAGE);
+#endif
+    return aligned;
+}
+
+// Returns a zero-initialized array of size elements placed according to the current policy.
+template <typename T>
+array_ptr<T> makeArray(const size_t size) {
+    static_assert(std::is_trivial<T>::value, "makeArray supports only trivial types");
+    const AllocPolicy policy = getAllocPolicy();
+    const size_t bytes = sizeof(T) * size;
+    if (policy != kAllocDefault && bytes >= kHugePageSize) {
+        const size_t mapped_bytes = (bytes + kHugePageSize - 1) & ~(kHugePageSize - 1);
+        void* ptr = mapHugePages(mapped_bytes, policy);
+        if (ptr != nullptr) return array_ptr<T>(static_cast<T*>(ptr), ArrayDeleter{mapped_bytes});
+    }
+    return array_ptr<T>(new T[size]());
+}
+
+// A single cache-line aligned buffer holding the arrays of a whole trie. Arrays relocated into
+// the arena become non-owning, so the arena must outlive them.
+class Arena {
+  public:
+    static const size_t kAlignment = 64;
+
+    Arena() = default;
+    explicit Arena(const size_t capacity)
+        : capacity_(capacity), buffer_(makeArray<CacheLine>(capacity / kAlignment)) {
+        assert(capacity % kAlignment == 0);
+    }
+
+    // Bytes occupied by an array of size elements, including padding
+    template <typename T>
+    static size_t footprint(const size_t size) {
+        return (sizeof(T) * size + kAlignment - 1) & ~(kAlignment - 1);
+    }
+
+    // Copies the array into the arena and makes arr refer to the copy.
+    template <typename T>
+    void relocate(array_ptr<T>& arr, const size_t size) {
+        if (!arr) return;
+        assert(used_ + footprint<T>(size) <= capacity_);
+        T* dst = reinterpret_cast<T*>(reinterpret_cast<char*>(buffer_.get()) + used_);
+        memcpy(dst, arr.get(), sizeof(T) * size);
+        used_ += footprint<T>(size);
+        arr = array_ptr<T>(dst, ArrayDeleter{0, true});
+    }
+
+    size_t capacity() const {
+        return capacity_;
+    }
+    size_t used() const {
+        return used_;
+    }
+
+  private:
+    struct alignas(kAlignment) CacheLine {
+        char bytes[kAlignment];
+    };
+
+    size_t capacity_ = 0;
+    size_t used_ = 0;
+    array_ptr<CacheLine> buffer_;
+};
+
+}  // namespace surf
+
+#endif  // ALLOCATOR_H_
@@ -31,7 +31,7 @@ class Bitvector {
         num_bits_ = totalNumBits(num_bits_per_level, start_level, end_level);
 
         // Modified by Shunsuke Kanda
-        bits_ = std::make_unique<word_t[]>(numWords());
+        bits_ = makeArray<word_t>(numWords());
         memset(bits_.get(), 0, bitsSize());
         // bits_ = new word_t[numWords()];
         // memset(bits_, 0, bitsSize());
@@ -43,6 +43,9 @@ class Bitvector {
     virtual ~Bitvector() {}
     // ~Bitvector() {}
 
+    Bitvector(Bitvector&&) = default;
+    Bitvector& operator=(Bitvector&&) = default;
+
     position_t numBits() const {
         return num_bits_;
     }
@@ -65,10 +68,23 @@ class Bitvector {
     }
 
     bool readBit(const position_t pos) const;
+    // Returns the word_id-th word, the first bit at the most significant bit
+    word_t readWord(const position_t word_id) const {
+        assert(word_id < numWords());
+        return bits_[word_id];
+    }
 
     position_t distanceToNextSetBit(const position_t pos) const;
     position_t distanceToPrevSetBit(const position_t pos) const;
 
+    // for packing into an Arena (see allocator.hpp)
+    size_t arenaBytes() const {
+        return Arena::footprint<word_t>(numWords());
+    }
+    void moveToArena(Arena& arena) {
+        arena.relocate(bits_, numWords());
+    }
+
   private:
     position_t totalNumBits(const std::vector<position_t>& num_bits_per_level, const level_t start_level,
                             const level_t end_level /* non-inclusive */);
@@ -91,7 +107,7 @@ class Bitvector {
   protected:
     // Modified by Shunsuke Kanda
     position_t num_bits_ = 0;
-    std::unique_ptr<word_t[]> bits_;
+    array_ptr<word_t> bits_;
     // word_t* bits_;
 };  // namespace surf
 
@@ -118,13 +134,14 @@ position_t Bitvector::distanceToNextSetBit(const position_t pos) const {
         distance += (kWordSize - offset);
     }
 
-    while (word_id < numWords()) {
+    // stops at the last word rather than reading past it
+    while (word_id < numWords() - 1) {
         word_id++;
         test_bits = bits_[word_id];
         if (test_bits > 0) return (distance + __builtin_clzll(test_bits));
         distance += kWordSize;
     }
-    return distance;
+    return (num_bits_ - pos);
 }
 
 position_t Bitvector::distanceToPrevSetBit(const position_t pos) const {
@@ -183,7 +200,8 @@ void Bitvector::concatenateBitvectors(const std::vector<std::vector<word_t> >& b
                 bit_shift += bits_remain;
             } else {
                 word_id++;
-                bits_[word_id] |= (last_word << (kWordSize - bit_shift));
+                // nothing spills over (past the array) if the word is exactly filled
+                if (bit_shift + bits_remain > kWordSize) bits_[word_id] |= (last_word << (kWordSize - bit_shift));
                 bit_shift = bit_shift + bits_remain - kWordSize;
             }
         }
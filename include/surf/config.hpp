@@ -20,6 +20,8 @@
 #include <type_traits>
 #include <utility>
 
+#include "allocator.hpp"
+
 namespace surf {
 
 using level_t = uint32_t;
@@ -77,7 +79,7 @@ inline void saveValue(std::ostream& os, T val) {
     os.write(reinterpret_cast<const char*>(&val), sizeof(T));
 }
 template <typename T>
-inline void saveArray(std::ostream& os, const std::unique_ptr<T[]>& ptr, size_t size) {
+inline void saveArray(std::ostream& os, const array_ptr<T>& ptr, size_t size) {
     os.write(reinterpret_cast<const char*>(ptr.get()), sizeof(T) * size);
 }
 template <typename T>
@@ -85,8 +87,8 @@ inline void loadValue(std::istream& is, T& val) {
     is.read(reinterpret_cast<char*>(&val), sizeof(T));
 }
 template <typename T>
-inline void loadArray(std::istream& is, std::unique_ptr<T[]>& ptr, size_t size) {
-    ptr = std::make_unique<T[]>(size);
+inline void loadArray(std::istream& is, array_ptr<T>& ptr, size_t size) {
+    ptr = makeArray<T>(size);
     is.read(reinterpret_cast<char*>(ptr.get()), sizeof(T) * size);
 }
 
@@ -16,6 +16,7 @@
 #include <vector>
 
 #include "config.hpp"
+#include "traversal_stats.hpp"
 
 namespace surf {
 
@@ -33,7 +34,7 @@ class LabelVector {
         for (level_t level = start_level; level < end_level; level++) num_bytes_ += labels_per_level[level].size();
 
         // Modified by Shunsuke Kanda (+16 is for avoiding heap overflow in SIMD)
-        labels_ = std::make_unique<label_t[]>(num_bytes_ + 16);
+        labels_ = makeArray<label_t>(num_bytes_ + 16);
         // labels_ = new label_t[num_bytes_];
 
         position_t pos = 0;
@@ -47,6 +48,9 @@ class LabelVector {
 
     ~LabelVector() {}
 
+    LabelVector(LabelVector&&) = default;
+    LabelVector& operator=(LabelVector&&) = default;
+
     position_t getNumBytes() const {
         return num_bytes_;
     }
@@ -69,7 +73,13 @@ class LabelVector {
         return labels_[pos];
     }
 
-    bool search(const label_t target, position_t& pos, const position_t search_len) const;
+    // stats is an instrumentation policy in traversal_stats.hpp
+    bool search(const label_t target, position_t& pos, const position_t search_len) const {
+        NoStats stats;
+        return search(target, pos, search_len, stats);
+    }
+    template <class Stats>
+    bool search(const label_t target, position_t& pos, position_t search_len, Stats& stats) const;
     bool searchGreaterThan(const label_t target, position_t& pos, const position_t search_len) const;
 
     bool binarySearch(const label_t target, position_t& pos, const position_t search_len) const;
@@ -111,26 +121,39 @@ class LabelVector {
         loadValue(is, num_bytes_);
         loadArray(is, labels_, num_bytes_ + 16);  // +16 is for avoiding heap overflow in SIMD
     }
+    size_t arenaBytes() const {
+        return Arena::footprint<label_t>(num_bytes_ + 16);
+    }
+    void moveToArena(Arena& arena) {
+        arena.relocate(labels_, num_bytes_ + 16);
+    }
 
   private:
     // Modified by Shunsuke Kanda
     position_t num_bytes_ = 0;
-    std::unique_ptr<label_t[]> labels_;
+    array_ptr<label_t> labels_;
     // label_t* labels_;
 };
 
-bool LabelVector::search(const label_t target, position_t& pos, position_t search_len) const {
+template <class Stats>
+bool LabelVector::search(const label_t target, position_t& pos, position_t search_len, Stats& stats) const {
     // skip terminator label
     if ((search_len > 1) && (labels_[pos] == kTerminator)) {
         pos++;
         search_len--;
     }
 
-    if (search_len < 3) return linearSearch(target, pos, search_len);
-    if (search_len < 12)
+    if (search_len < 3) {
+        stats.onLabelSearch(kLinearSearch);
+        return linearSearch(target, pos, search_len);
+    }
+    if (search_len < 12) {
+        stats.onLabelSearch(kBinarySearch);
         return binarySearch(target, pos, search_len);
-    else
+    } else {
+        stats.onLabelSearch(kSimdSearch);
         return simdSearch(target, pos, search_len);
+    }
 }
 
 bool LabelVector::searchGreaterThan(const label_t target, position_t& pos, position_t search_len) const {
@@ -11,12 +11,14 @@
 #ifndef LOUDSDENSE_H_
 #define LOUDSDENSE_H_
 
+#include <algorithm>
 #include <string>
 
 #include "config.hpp"
 #include "rank.hpp"
 #include "suffix.hpp"
 #include "surf_builder.hpp"
+#include "traversal_stats.hpp"
 
 namespace surf {
 
@@ -25,7 +27,8 @@ class LoudsDense {
     class Iter {
       public:
         Iter() : is_valid_(false){};
-        Iter(LoudsDense* trie)
+        // the trie is only read
+        Iter(const LoudsDense* trie)
             : is_valid_(false),
               is_search_complete_(false),
               is_move_left_complete_(false),
@@ -91,7 +94,7 @@ class LoudsDense {
         bool is_move_left_complete_;
         // If false, call moveToRightMostKey in LoudsSparse to complete
         bool is_move_right_complete_;
-        LoudsDense* trie_;
+        const LoudsDense* trie_;
         position_t send_out_node_num_;
         level_t key_len_;  // Does NOT include suffix
 
@@ -104,10 +107,14 @@ class LoudsDense {
 
   public:
     LoudsDense(){};
-    LoudsDense(const SuRFBuilder* builder);
+    // rank_block_size is the rank sampling rate, a power of two and at least 64
+    LoudsDense(const SuRFBuilder* builder, const position_t rank_block_size = kRankBasicBlockSize);
 
     ~LoudsDense() {}
 
+    LoudsDense(LoudsDense&&) = default;
+    LoudsDense& operator=(LoudsDense&&) = default;
+
     // Returns whether key exists in the trie so far
     // out_node_num == 0 means search terminates in louds-dense.
     bool lookupKey(const std::string& key, position_t& out_node_num) const;
@@ -163,45 +170,82 @@ class LoudsDense {
   public:
     // Added by Shunsuke Kanda
     std::pair<position_t, level_t> findKey(const std::string& key, position_t& out_node_num) const {
-        assert(suffixes_->getType() == kNone);
-
-        position_t node_num = 0;
+        NoStats stats;
+        return findKey(key, 0, 0, out_node_num, stats);
+    }
+    // trie walk starts at node "in_node_num" in level "in_level" instead of root;
+    // stats is an instrumentation policy in traversal_stats.hpp
+    template <class Stats>
+    std::pair<position_t, level_t> findKey(const std::string& key, const level_t in_level, const position_t in_node_num,
+                                           position_t& out_node_num, Stats& stats) const {
+        assert(suffixes_.getType() == kNone);
+
+        position_t node_num = in_node_num;
         position_t pos = 0;
 
         out_node_num = kNotFound;
 
-        for (level_t level = 0; level < height_; level++) {
+        for (level_t level = in_level; level < height_; level++) {
+            stats.onDenseLevel();
             pos = (node_num * kNodeFanout);
             if (level >= key.length()) {  // if run out of searchKey bytes
-                if (prefixkey_indicator_bits_->readBit(node_num))  // if the prefix is also a key
+                if (prefixkey_indicator_bits_.readBit(node_num)) {  // if the prefix is also a key
+                    stats.onRank(3);
                     return {getSuffixPos(pos, true), level};
-                else
-                    return {kNotFound, level};
+                }
+                return {kNotFound, level};
             }
             pos += (label_t)key[level];
 
-            child_indicator_bitmaps_->prefetch(pos);
+            child_indicator_bitmaps_.prefetch(pos);
 
-            if (!label_bitmaps_->readBit(pos))  // if key byte does not exist
+            if (!label_bitmaps_.readBit(pos))  // if key byte does not exist
                 return {kNotFound, level + 1};
 
-            if (!child_indicator_bitmaps_->readBit(pos))  // if trie branch terminates
+            if (!child_indicator_bitmaps_.readBit(pos)) {  // if trie branch terminates
+                stats.onRank(3);
                 return {getSuffixPos(pos, false), level + 1};
+            }
 
+            stats.onRank();
             node_num = getChildNodeNum(pos);
         }
         // search will continue in LoudsSparse
         out_node_num = node_num;
         return {kNotFound, height_};
     }
+    // Returns the child node number, or the key id if the branch terminates (is_leaf is set),
+    // or kNotFound if label does not exist in the node.
+    position_t moveToChild(const position_t node_num, const label_t label, bool& is_leaf) const {
+        const position_t pos = node_num * kNodeFanout + label;
+        if (!label_bitmaps_.readBit(pos)) return kNotFound;
+        is_leaf = !child_indicator_bitmaps_.readBit(pos);
+        return is_leaf ? getSuffixPos(pos, false) : getChildNodeNum(pos);
+    }
+    // For ordered traversals: returns the key id of the prefix key of the node, or kNotFound
+    position_t getPrefixKeyId(const position_t node_num) const {
+        return prefixkey_indicator_bits_.readBit(node_num) ? getSuffixPos(node_num * kNodeFanout, true) : kNotFound;
+    }
+    // Returns the smallest label in the node not less than from, or kFanout if none
+    position_t nextLabel(const position_t node_num, position_t from) const {
+        if (from >= kNodeFanout) return kNodeFanout;
+        const position_t pos = node_num * kNodeFanout + from;
+        if (label_bitmaps_.readBit(pos)) return from;
+        return std::min(from + label_bitmaps_.distanceToNextSetBit(pos), position_t(kNodeFanout));
+    }
+    // For simultaneous traversals: the i-th of the kNodeFanout / kWordSize words of the label
+    // bitmap of the node, the smallest label at the most significant bit
+    word_t getLabelWord(const position_t node_num, const position_t i) const {
+        return label_bitmaps_.readWord(node_num * (kNodeFanout / kWordSize) + i);
+    }
     void debugPrint(std::ostream& os) const {
         os << "-- LoudsDense (heigth=" << height_ << ") --\n";
         std::vector<std::vector<position_t>> Ps;
         os << "LABEL: ";
-        for (position_t i = 0; i < label_bitmaps_->numBits(); i += kNodeFanout) {
+        for (position_t i = 0; i < label_bitmaps_.numBits(); i += kNodeFanout) {
             std::vector<position_t> P;
             for (position_t j = i; j < i + kNodeFanout; ++j) {
-                if (label_bitmaps_->readBit(j)) {
+                if (label_bitmaps_.readBit(j)) {
                     label_t c = label_t(j % kNodeFanout);
                     os << char(c != kTerminator ? c : '?') << " ";
                     P.push_back(j);
@@ -214,14 +258,14 @@ class LoudsDense {
         os << "CHILD: ";
         for (position_t i = 0; i < Ps.size(); ++i) {
             for (position_t j : Ps[i]) {
-                os << int(child_indicator_bitmaps_->readBit(j)) << " ";
+                os << int(child_indicator_bitmaps_.readBit(j)) << " ";
             }
             os << "| ";
         }
         os << '\n';
         os << "PREFX: ";
         for (position_t i = 0; i < Ps.size(); ++i) {
-            os << int(prefixkey_indicator_bits_->readBit(i)) << " ";
+            os << int(prefixkey_indicator_bits_.readBit(i)) << " ";
             for (position_t j = 1; j < Ps[i].size(); ++j) {
                 os << "  ";
             }
@@ -231,27 +275,33 @@ class LoudsDense {
     }
     void save(std::ostream& os) const {
         saveValue(os, height_);
-        label_bitmaps_->save(os);
-        child_indicator_bitmaps_->save(os);
-        prefixkey_indicator_bits_->save(os);
-        suffixes_->save(os);
+        label_bitmaps_.save(os);
+        child_indicator_bitmaps_.save(os);
+        prefixkey_indicator_bits_.save(os);
+        suffixes_.save(os);
     }
     void load(std::istream& is) {
         loadValue(is, height_);
-        label_bitmaps_ = std::make_unique<BitvectorRank>();
-        label_bitmaps_->load(is);
-        child_indicator_bitmaps_ = std::make_unique<BitvectorRank>();
-        child_indicator_bitmaps_->load(is);
-        prefixkey_indicator_bits_ = std::make_unique<BitvectorRank>();
-        prefixkey_indicator_bits_->load(is);
-        suffixes_ = std::make_unique<BitvectorSuffix>();
-        suffixes_->load(is);
+        label_bitmaps_.load(is);
+        child_indicator_bitmaps_.load(is);
+        prefixkey_indicator_bits_.load(is);
+        suffixes_.load(is);
+    }
+    size_t arenaBytes() const {
+        return label_bitmaps_.arenaBytes() + child_indicator_bitmaps_.arenaBytes() +
+               prefixkey_indicator_bits_.arenaBytes() + suffixes_.arenaBytes();
+    }
+    void moveToArena(Arena& arena) {
+        label_bitmaps_.moveToArena(arena);
+        child_indicator_bitmaps_.moveToArena(arena);
+        prefixkey_indicator_bits_.moveToArena(arena);
+        suffixes_.moveToArena(arena);
     }
     uint64_t getNumNodes() const {
         uint64_t num = 0;
-        for (position_t i = 0; i < label_bitmaps_->numBits(); i += kNodeFanout) {
+        for (position_t i = 0; i < label_bitmaps_.numBits(); i += kNodeFanout) {
             for (position_t j = i; j < i + kNodeFanout; ++j) {
-                if (label_bitmaps_->readBit(j)) ++num;
+                if (label_bitmaps_.readBit(j)) ++num;
             }
         }
         return num;
@@ -264,10 +314,10 @@ class LoudsDense {
     level_t height_ = 0;
 
     // Modified by Shunsuke Kanda
-    std::unique_ptr<BitvectorRank> label_bitmaps_;
-    std::unique_ptr<BitvectorRank> child_indicator_bitmaps_;
-    std::unique_ptr<BitvectorRank> prefixkey_indicator_bits_;  // 1 bit per internal node
-    std::unique_ptr<BitvectorSuffix> suffixes_;
+    BitvectorRank label_bitmaps_;
+    BitvectorRank child_indicator_bitmaps_;
+    BitvectorRank prefixkey_indicator_bits_;  // 1 bit per internal node
+    BitvectorSuffix suffixes_;
     // BitvectorRank* label_bitmaps_;
     // BitvectorRank* child_indicator_bitmaps_;
     // BitvectorRank* prefixkey_indicator_bits_;  // 1 bit per internal node
@@ -277,19 +327,19 @@ class LoudsDense {
 const position_t LoudsDense::kNodeFanout = 256;
 const position_t LoudsDense::kRankBasicBlockSize = 512;
 
-LoudsDense::LoudsDense(const SuRFBuilder* builder) {
+LoudsDense::LoudsDense(const SuRFBuilder* builder, const position_t rank_block_size) {
+    assert(rank_block_size >= kWordSize && (rank_block_size & (rank_block_size - 1)) == 0);
     height_ = builder->getSparseStartLevel();
     std::vector<position_t> num_bits_per_level;
     for (level_t level = 0; level < height_; level++)
         num_bits_per_level.push_back(builder->getBitmapLabels()[level].size() * kWordSize);
 
     // Modified by Shunsuke Kanda
-    label_bitmaps_ = std::make_unique<BitvectorRank>(kRankBasicBlockSize, builder->getBitmapLabels(),
-                                                     num_bits_per_level, 0, height_);
-    child_indicator_bitmaps_ = std::make_unique<BitvectorRank>(
-        kRankBasicBlockSize, builder->getBitmapChildIndicatorBits(), num_bits_per_level, 0, height_);
-    prefixkey_indicator_bits_ = std::make_unique<BitvectorRank>(
-        kRankBasicBlockSize, builder->getPrefixkeyIndicatorBits(), builder->getNodeCounts(), 0, height_);
+    label_bitmaps_ = BitvectorRank(rank_block_size, builder->getBitmapLabels(), num_bits_per_level, 0, height_);
+    child_indicator_bitmaps_ =
+        BitvectorRank(rank_block_size, builder->getBitmapChildIndicatorBits(), num_bits_per_level, 0, height_);
+    prefixkey_indicator_bits_ =
+        BitvectorRank(rank_block_size, builder->getPrefixkeyIndicatorBits(), builder->getNodeCounts(), 0, height_);
     // label_bitmaps_ = new BitvectorRank(kRankBasicBlockSize, builder->getBitmapLabels(), num_bits_per_level, 0,
     // height_);
     // child_indicator_bitmaps_ =
@@ -298,9 +348,10 @@ LoudsDense::LoudsDense(const SuRFBuilder* builder) {
     // prefixkey_indicator_bits_ = new BitvectorRank(kRankBasicBlockSize, builder->getPrefixkeyIndicatorBits(),
     //                                               builder->getNodeCounts(), 0, height_);
 
-    if (builder->getSuffixType() == kNone) {
+    // without dense levels, end_level 0 would mean all the levels
+    if (builder->getSuffixType() == kNone || height_ == 0) {
         // Modified by Shunsuke Kanda
-        suffixes_ = std::make_unique<BitvectorSuffix>();
+        suffixes_ = BitvectorSuffix();
         // suffixes_ = new BitvectorSuffix();
     } else {
         level_t hash_suffix_len = builder->getHashSuffixLen();
@@ -310,8 +361,8 @@ LoudsDense::LoudsDense(const SuRFBuilder* builder) {
         for (level_t level = 0; level < height_; level++)
             num_suffix_bits_per_level.push_back(builder->getSuffixCounts()[level] * suffix_len);
         // Modified by Shunsuke Kanda
-        suffixes_ = std::make_unique<BitvectorSuffix>(builder->getSuffixType(), hash_suffix_len, real_suffix_len,
-                                                      builder->getSuffixes(), num_suffix_bits_per_level, 0, height_);
+        suffixes_ = BitvectorSuffix(builder->getSuffixType(), hash_suffix_len, real_suffix_len, builder->getSuffixes(),
+                                    num_suffix_bits_per_level, 0, height_);
         // suffixes_ = new BitvectorSuffix(builder->getSuffixType(), hash_suffix_len, real_suffix_len,
         //                                 builder->getSuffixes(), num_suffix_bits_per_level, 0, height_);
     }
@@ -323,8 +374,8 @@ bool LoudsDense::lookupKey(const std::string& key, position_t& out_node_num) con
     for (level_t level = 0; level < height_; level++) {
         pos = (node_num * kNodeFanout);
         if (level >= key.length()) {  // if run out of searchKey bytes
-            if (prefixkey_indicator_bits_->readBit(node_num))  // if the prefix is also a key
-                return suffixes_->checkEquality(getSuffixPos(pos, true), key, level + 1);
+            if (prefixkey_indicator_bits_.readBit(node_num))  // if the prefix is also a key
+                return suffixes_.checkEquality(getSuffixPos(pos, true), key, level + 1);
             else
                 return false;
         }
@@ -332,11 +383,11 @@ bool LoudsDense::lookupKey(const std::string& key, position_t& out_node_num) con
 
         // child_indicator_bitmaps_->prefetch(pos);
 
-        if (!label_bitmaps_->readBit(pos))  // if key byte does not exist
+        if (!label_bitmaps_.readBit(pos))  // if key byte does not exist
             return false;
 
-        if (!child_indicator_bitmaps_->readBit(pos))  // if trie branch terminates
-            return suffixes_->checkEquality(getSuffixPos(pos, false), key, level + 1);
+        if (!child_indicator_bitmaps_.readBit(pos))  // if trie branch terminates
+            return suffixes_.checkEquality(getSuffixPos(pos, false), key, level + 1);
 
         node_num = getChildNodeNum(pos);
     }
@@ -353,12 +404,15 @@ bool LoudsDense::moveToKeyGreaterThan(const std::string& key, const bool inclusi
         pos = node_num * kNodeFanout;
         if (level >= key.length()) {  // if run out of searchKey bytes
             iter.append(getNextPos(pos - 1));
-            if (prefixkey_indicator_bits_->readBit(node_num))  // if the prefix is also a key
+            // moveToLeftMostKey sets the flags, possibly leaving moveLeft incomplete for LoudsSparse,
+            // so they must not be overwritten
+            if (prefixkey_indicator_bits_.readBit(node_num)) {  // if the prefix is also a key
                 iter.is_at_prefix_key_ = true;
-            else
+                // valid, search complete, moveLeft complete, moveRight complete
+                iter.setFlags(true, true, true, true);
+            } else {
                 iter.moveToLeftMostKey();
-            // valid, search complete, moveLeft complete, moveRight complete
-            iter.setFlags(true, true, true, true);
+            }
             return true;
         }
 
@@ -366,12 +420,12 @@ bool LoudsDense::moveToKeyGreaterThan(const std::string& key, const bool inclusi
         iter.append(pos);
 
         // if no exact match
-        if (!label_bitmaps_->readBit(pos)) {
+        if (!label_bitmaps_.readBit(pos)) {
             iter++;
             return false;
         }
         // if trie branch terminates
-        if (!child_indicator_bitmaps_->readBit(pos))
+        if (!child_indicator_bitmaps_.readBit(pos))
             return compareSuffixGreaterThan(pos, key, level + 1, inclusive, iter);
         node_num = getChildNodeNum(pos);
     }
@@ -384,35 +438,38 @@ bool LoudsDense::moveToKeyGreaterThan(const std::string& key, const bool inclusi
 }
 
 uint64_t LoudsDense::serializedSize() const {
-    uint64_t size = sizeof(height_) + label_bitmaps_->serializedSize() + child_indicator_bitmaps_->serializedSize() +
-                    prefixkey_indicator_bits_->serializedSize() + suffixes_->serializedSize();
+    uint64_t size = sizeof(height_) + label_bitmaps_.serializedSize() + child_indicator_bitmaps_.serializedSize() +
+                    prefixkey_indicator_bits_.serializedSize() + suffixes_.serializedSize();
     sizeAlign(size);
     return size;
 }
 
+// The components are held in place, so sizeof(LoudsDense) already covers them.
 uint64_t LoudsDense::getMemoryUsage() const {
-    return (sizeof(LoudsDense) + label_bitmaps_->size() + child_indicator_bitmaps_->size() +
-            prefixkey_indicator_bits_->size() + suffixes_->size());
+    return (sizeof(LoudsDense) + label_bitmaps_.size() + child_indicator_bitmaps_.size() +
+            prefixkey_indicator_bits_.size() + suffixes_.size()) -
+           (sizeof(label_bitmaps_) + sizeof(child_indicator_bitmaps_) + sizeof(prefixkey_indicator_bits_) +
+            sizeof(suffixes_));
 }
 
 position_t LoudsDense::getChildNodeNum(const position_t pos) const {
-    return child_indicator_bitmaps_->rank(pos);
+    return child_indicator_bitmaps_.rank(pos);
 }
 
 position_t LoudsDense::getSuffixPos(const position_t pos, const bool is_prefix_key) const {
     position_t node_num = pos / kNodeFanout;
-    position_t suffix_pos = (label_bitmaps_->rank(pos) - child_indicator_bitmaps_->rank(pos) +
-                             prefixkey_indicator_bits_->rank(node_num) - 1);
-    if (is_prefix_key && label_bitmaps_->readBit(pos) && !child_indicator_bitmaps_->readBit(pos)) suffix_pos--;
+    position_t suffix_pos = (label_bitmaps_.rank(pos) - child_indicator_bitmaps_.rank(pos) +
+                             prefixkey_indicator_bits_.rank(node_num) - 1);
+    if (is_prefix_key && label_bitmaps_.readBit(pos) && !child_indicator_bitmaps_.readBit(pos)) suffix_pos--;
     return suffix_pos;
 }
 
 position_t LoudsDense::getNextPos(const position_t pos) const {
-    return pos + label_bitmaps_->distanceToNextSetBit(pos);
+    return pos + label_bitmaps_.distanceToNextSetBit(pos);
 }
 
 position_t LoudsDense::getPrevPos(const position_t pos, bool* is_out_of_bound) const {
-    position_t distance = label_bitmaps_->distanceToPrevSetBit(pos);
+    position_t distance = label_bitmaps_.distanceToPrevSetBit(pos);
     if (pos <= distance) {
         *is_out_of_bound = true;
         return 0;
@@ -424,7 +481,7 @@ position_t LoudsDense::getPrevPos(const position_t pos, bool* is_out_of_bound) c
 bool LoudsDense::compareSuffixGreaterThan(const position_t pos, const std::string& key, const level_t level,
                                           const bool inclusive, LoudsDense::Iter& iter) const {
     position_t suffix_pos = getSuffixPos(pos, false);
-    int compare = suffixes_->compare(suffix_pos, key, level);
+    int compare = suffixes_.compare(suffix_pos, key, level);
     if ((compare != kCouldBePositive) && (compare < 0)) {
         iter++;
         return false;
@@ -450,7 +507,7 @@ int LoudsDense::Iter::compare(const std::string& key) const {
     if (compare != 0) return compare;
     if (isComplete()) {
         position_t suffix_pos = trie_->getSuffixPos(pos_in_trie_[key_len_ - 1], is_at_prefix_key_);
-        return trie_->suffixes_->compare(suffix_pos, key, key_len_);
+        return trie_->suffixes_.compare(suffix_pos, key, key_len_);
     }
     return compare;
 }
@@ -463,10 +520,10 @@ std::string LoudsDense::Iter::getKey() const {
 }
 
 int LoudsDense::Iter::getSuffix(word_t* suffix) const {
-    if (isComplete() && ((trie_->suffixes_->getType() == kReal) || (trie_->suffixes_->getType() == kMixed))) {
+    if (isComplete() && ((trie_->suffixes_.getType() == kReal) || (trie_->suffixes_.getType() == kMixed))) {
         position_t suffix_pos = trie_->getSuffixPos(pos_in_trie_[key_len_ - 1], is_at_prefix_key_);
-        *suffix = trie_->suffixes_->readReal(suffix_pos);
-        return trie_->suffixes_->getRealSuffixLen();
+        *suffix = trie_->suffixes_.readReal(suffix_pos);
+        return trie_->suffixes_.getRealSuffixLen();
     }
     *suffix = 0;
     return 0;
@@ -474,11 +531,11 @@ int LoudsDense::Iter::getSuffix(word_t* suffix) const {
 
 std::string LoudsDense::Iter::getKeyWithSuffix(unsigned* bitlen) const {
     std::string iter_key = getKey();
-    if (isComplete() && ((trie_->suffixes_->getType() == kReal) || (trie_->suffixes_->getType() == kMixed))) {
+    if (isComplete() && ((trie_->suffixes_.getType() == kReal) || (trie_->suffixes_.getType() == kMixed))) {
         position_t suffix_pos = trie_->getSuffixPos(pos_in_trie_[key_len_ - 1], is_at_prefix_key_);
-        word_t suffix = trie_->suffixes_->readReal(suffix_pos);
+        word_t suffix = trie_->suffixes_.readReal(suffix_pos);
         if (suffix > 0) {
-            level_t suffix_len = trie_->suffixes_->getRealSuffixLen();
+            level_t suffix_len = trie_->suffixes_.getRealSuffixLen();
             *bitlen = suffix_len % 8;
             suffix <<= (64 - suffix_len);
             char* suffix_str = reinterpret_cast<char*>(&suffix);
@@ -516,7 +573,7 @@ void LoudsDense::Iter::setFlags(const bool is_valid, const bool is_search_comple
 }
 
 void LoudsDense::Iter::setToFirstLabelInRoot() {
-    if (trie_->label_bitmaps_->readBit(0)) {
+    if (trie_->label_bitmaps_.readBit(0)) {
         pos_in_trie_[0] = 0;
         key_[0] = (label_t)0;
     } else {
@@ -537,14 +594,14 @@ void LoudsDense::Iter::moveToLeftMostKey() {
     assert(key_len_ > 0);
     level_t level = key_len_ - 1;
     position_t pos = pos_in_trie_[level];
-    if (!trie_->child_indicator_bitmaps_->readBit(pos))
+    if (!trie_->child_indicator_bitmaps_.readBit(pos))
         // valid, search complete, moveLeft complete, moveRight complete
         return setFlags(true, true, true, true);
 
     while (level < trie_->getHeight() - 1) {
         position_t node_num = trie_->getChildNodeNum(pos);
         // if the current prefix is also a key
-        if (trie_->prefixkey_indicator_bits_->readBit(node_num)) {
+        if (trie_->prefixkey_indicator_bits_.readBit(node_num)) {
             append(trie_->getNextPos(node_num * kNodeFanout - 1));
             is_at_prefix_key_ = true;
             // valid, search complete, moveLeft complete, moveRight complete
@@ -555,7 +612,7 @@ void LoudsDense::Iter::moveToLeftMostKey() {
         append(pos);
 
         // if trie branch terminates
-        if (!trie_->child_indicator_bitmaps_->readBit(pos))
+        if (!trie_->child_indicator_bitmaps_.readBit(pos))
             // valid, search complete, moveLeft complete, moveRight complete
             return setFlags(true, true, true, true);
 
@@ -570,7 +627,7 @@ void LoudsDense::Iter::moveToRightMostKey() {
     assert(key_len_ > 0);
     level_t level = key_len_ - 1;
     position_t pos = pos_in_trie_[level];
-    if (!trie_->child_indicator_bitmaps_->readBit(pos))
+    if (!trie_->child_indicator_bitmaps_.readBit(pos))
         // valid, search complete, moveLeft complete, moveRight complete
         return setFlags(true, true, true, true);
 
@@ -585,7 +642,7 @@ void LoudsDense::Iter::moveToRightMostKey() {
         append(pos);
 
         // if trie branch terminates
-        if (!trie_->child_indicator_bitmaps_->readBit(pos))
+        if (!trie_->child_indicator_bitmaps_.readBit(pos))
             // valid, search complete, moveLeft complete, moveRight complete
             return setFlags(true, true, true, true);
 
@@ -636,7 +693,7 @@ void LoudsDense::Iter::operator--(int) {
     while ((prev_pos / kNodeFanout) < (pos / kNodeFanout)) {
         // if the current prefix is also a key
         position_t node_num = pos / kNodeFanout;
-        if (trie_->prefixkey_indicator_bits_->readBit(node_num)) {
+        if (trie_->prefixkey_indicator_bits_.readBit(node_num)) {
             is_at_prefix_key_ = true;
             // valid, search complete, moveLeft complete, moveRight complete
             return setFlags(true, true, true, true);
@@ -19,6 +19,7 @@
 #include "select.hpp"
 #include "suffix.hpp"
 #include "surf_builder.hpp"
+#include "traversal_stats.hpp"
 
 namespace surf {
 
@@ -27,7 +28,8 @@ class LoudsSparse {
     class Iter {
       public:
         Iter() : is_valid_(false){};
-        Iter(LoudsSparse* trie)
+        // the trie is only read
+        Iter(const LoudsSparse* trie)
             : is_valid_(false), trie_(trie), start_node_num_(0), key_len_(0), is_at_terminator_(false) {
             start_level_ = trie_->getStartLevel();
             for (level_t level = start_level_; level < trie_->getHeight(); level++) {
@@ -66,7 +68,7 @@ class LoudsSparse {
 
       private:
         bool is_valid_;  // True means the iter currently points to a valid key
-        LoudsSparse* trie_;
+        const LoudsSparse* trie_;
         level_t start_level_;
         position_t start_node_num_;  // Passed in by the dense iterator; default = 0
         level_t key_len_;  // Start counting from start_level_; does NOT include suffix
@@ -80,10 +82,16 @@ class LoudsSparse {
 
   public:
     LoudsSparse(){};
-    LoudsSparse(const SuRFBuilder* builder);
+    // rank_block_size and select_sample_interval are the sampling rates of rank and select;
+    // rank_block_size is a power of two and at least 64
+    LoudsSparse(const SuRFBuilder* builder, const position_t rank_block_size = kRankBasicBlockSize,
+                const position_t select_sample_interval = kSelectSampleInterval);
 
     ~LoudsSparse() {}
 
+    LoudsSparse(LoudsSparse&&) = default;
+    LoudsSparse& operator=(LoudsSparse&&) = default;
+
     // point query: trie walk starts at node "in_node_num" instead of root
     // in_node_num is provided by louds-dense's lookupKey function
     bool lookupKey(const std::string& key, const position_t in_node_num) const;
@@ -158,42 +166,81 @@ class LoudsSparse {
   public:
     // Added by Shunsuke Kanda
     std::pair<position_t, level_t> findKey(const std::string& key, const position_t in_node_num) const {
-        assert(suffixes_->getType() == kNone);
+        NoStats stats;
+        return findKey(key, in_node_num, start_level_, stats);
+    }
+    // in_level is the level of node "in_node_num" (>= start_level_);
+    // stats is an instrumentation policy in traversal_stats.hpp
+    template <class Stats>
+    std::pair<position_t, level_t> findKey(const std::string& key, const position_t in_node_num, const level_t in_level,
+                                           Stats& stats) const {
+        assert(suffixes_.getType() == kNone);
         position_t node_num = in_node_num;
+        stats.onSelect();
         position_t pos = getFirstLabelPos(node_num);
         level_t level = 0;
-        for (level = start_level_; level < key.length(); level++) {
-            child_indicator_bits_->prefetch(pos);
-            if (!labels_->search((label_t)key[level], pos, nodeSize(pos))) return {kNotFound, level};
+        for (level = in_level; level < key.length(); level++) {
+            stats.onSparseLevel();
+            child_indicator_bits_.prefetch(pos);
+            if (!labels_.search((label_t)key[level], pos, nodeSize(pos), stats)) return {kNotFound, level};
             // if trie branch terminates
-            if (!child_indicator_bits_->readBit(pos)) {
+            if (!child_indicator_bits_.readBit(pos)) {
+                stats.onRank();
                 return {getSuffixPos(pos) + value_count_dense_, level + 1};
             }
             // move to child
+            stats.onRank();
+            stats.onSelect();
             node_num = getChildNodeNum(pos);
             pos = getFirstLabelPos(node_num);
         }
-        if ((labels_->read(pos) == kTerminator) && (!child_indicator_bits_->readBit(pos))) {
+        if ((labels_.read(pos) == kTerminator) && (!child_indicator_bits_.readBit(pos))) {
+            stats.onRank();
             return {getSuffixPos(pos) + value_count_dense_, level_t(key.length())};
         }
         return {kNotFound, level_t(key.length())};
     }
+    // Returns the child node number, or the key id if the branch terminates (is_leaf is set),
+    // or kNotFound if label does not exist in the node.
+    position_t moveToChild(const position_t node_num, const label_t label, bool& is_leaf) const {
+        position_t pos = getFirstLabelPos(node_num);
+        if (!labels_.search(label, pos, nodeSize(pos))) return kNotFound;
+        is_leaf = !child_indicator_bits_.readBit(pos);
+        return is_leaf ? getSuffixPos(pos) + value_count_dense_ : getChildNodeNum(pos);
+    }
+    // For ordered traversals: the labels of a node are at consecutive positions in label order,
+    // and a prefix key is the terminator label at the first position.
+    position_t getFirstPos(const position_t node_num) const {
+        return getFirstLabelPos(node_num);
+    }
+    // Returns the next position in the node of pos, or kNotFound at the end of the node
+    position_t getNextPosInNode(const position_t pos) const {
+        return (pos + 1 < louds_bits_.numBits() && !louds_bits_.readBit(pos + 1)) ? pos + 1 : kNotFound;
+    }
+    label_t getLabel(const position_t pos) const {
+        return labels_.read(pos);
+    }
+    // Returns the child node number, or the key id if the branch terminates (is_leaf is set).
+    position_t getChild(const position_t pos, bool& is_leaf) const {
+        is_leaf = !child_indicator_bits_.readBit(pos);
+        return is_leaf ? getSuffixPos(pos) + value_count_dense_ : getChildNodeNum(pos);
+    }
     void debugPrint(std::ostream& os) const {
         os << "-- LoudsSparse --\n";
         os << "LABEL: ";
-        for (position_t i = 0; i < labels_->getNumBytes(); ++i) {
-            label_t c = labels_->read(i);
+        for (position_t i = 0; i < labels_.getNumBytes(); ++i) {
+            label_t c = labels_.read(i);
             os << char(c != kTerminator ? c : '?') << " ";
         }
         os << '\n';
         os << "CHILD: ";
-        for (position_t i = 0; i < child_indicator_bits_->numBits(); ++i) {
-            os << int(child_indicator_bits_->readBit(i)) << " ";
+        for (position_t i = 0; i < child_indicator_bits_.numBits(); ++i) {
+            os << int(child_indicator_bits_.readBit(i)) << " ";
         }
         os << '\n';
         os << "LOUDS: ";
-        for (position_t i = 0; i < louds_bits_->numBits(); ++i) {
-            os << int(louds_bits_->readBit(i)) << " ";
+        for (position_t i = 0; i < louds_bits_.numBits(); ++i) {
+            os << int(louds_bits_.readBit(i)) << " ";
         }
         os << '\n';
     }
@@ -203,10 +250,10 @@ class LoudsSparse {
         saveValue(os, node_count_dense_);
         saveValue(os, child_count_dense_);
         saveValue(os, value_count_dense_);
-        labels_->save(os);
-        child_indicator_bits_->save(os);
-        louds_bits_->save(os);
-        suffixes_->save(os);
+        labels_.save(os);
+        child_indicator_bits_.save(os);
+        louds_bits_.save(os);
+        suffixes_.save(os);
     }
     void load(std::istream& is) {
         loadValue(is, height_);
@@ -214,17 +261,23 @@ class LoudsSparse {
         loadValue(is, node_count_dense_);
         loadValue(is, child_count_dense_);
         loadValue(is, value_count_dense_);
-        labels_ = std::make_unique<LabelVector>();
-        labels_->load(is);
-        child_indicator_bits_ = std::make_unique<BitvectorRank>();
-        child_indicator_bits_->load(is);
-        louds_bits_ = std::make_unique<BitvectorSelect>();
-        louds_bits_->load(is);
-        suffixes_ = std::make_unique<BitvectorSuffix>();
-        suffixes_->load(is);
+        labels_.load(is);
+        child_indicator_bits_.load(is);
+        louds_bits_.load(is);
+        suffixes_.load(is);
+    }
+    size_t arenaBytes() const {
+        return labels_.arenaBytes() + child_indicator_bits_.arenaBytes() + louds_bits_.arenaBytes() +
+               suffixes_.arenaBytes();
+    }
+    void moveToArena(Arena& arena) {
+        labels_.moveToArena(arena);
+        child_indicator_bits_.moveToArena(arena);
+        louds_bits_.moveToArena(arena);
+        suffixes_.moveToArena(arena);
     }
     uint64_t getNumNodes() const {
-        return louds_bits_->numBits();
+        return louds_bits_.numBits();
     }
 
   private:
@@ -243,10 +296,10 @@ class LoudsSparse {
     position_t value_count_dense_ = 0;
 
     // Modified by Shunsuke Kanda
-    std::unique_ptr<LabelVector> labels_;
-    std::unique_ptr<BitvectorRank> child_indicator_bits_;
-    std::unique_ptr<BitvectorSelect> louds_bits_;
-    std::unique_ptr<BitvectorSuffix> suffixes_;
+    LabelVector labels_;
+    BitvectorRank child_indicator_bits_;
+    BitvectorSelect louds_bits_;
+    BitvectorSuffix suffixes_;
     // LabelVector* labels_;
     // BitvectorRank* child_indicator_bits_;
     // BitvectorSelect* louds_bits_;
@@ -256,7 +309,10 @@ class LoudsSparse {
 const position_t LoudsSparse::kRankBasicBlockSize = 512;
 const position_t LoudsSparse::kSelectSampleInterval = 64;
 
-LoudsSparse::LoudsSparse(const SuRFBuilder* builder) {
+LoudsSparse::LoudsSparse(const SuRFBuilder* builder, const position_t rank_block_size,
+                         const position_t select_sample_interval) {
+    assert(rank_block_size >= kWordSize && (rank_block_size & (rank_block_size - 1)) == 0);
+    assert(select_sample_interval > 0);
     height_ = builder->getLabels().size();
     start_level_ = builder->getSparseStartLevel();
 
@@ -269,17 +325,17 @@ LoudsSparse::LoudsSparse(const SuRFBuilder* builder) {
         child_count_dense_ = node_count_dense_ + builder->getNodeCounts()[start_level_] - 1;
 
     // Modified by Shunsuke Kanda
-    labels_ = std::make_unique<LabelVector>(builder->getLabels(), start_level_, height_);
+    labels_ = LabelVector(builder->getLabels(), start_level_, height_);
     // labels_ = new LabelVector(builder->getLabels(), start_level_, height_);
 
     std::vector<position_t> num_items_per_level;
     for (level_t level = 0; level < height_; level++) num_items_per_level.push_back(builder->getLabels()[level].size());
 
     // Modified by Shunsuke Kanda
-    child_indicator_bits_ = std::make_unique<BitvectorRank>(kRankBasicBlockSize, builder->getChildIndicatorBits(),
-                                                            num_items_per_level, start_level_, height_);
-    louds_bits_ = std::make_unique<BitvectorSelect>(kSelectSampleInterval, builder->getLoudsBits(), num_items_per_level,
-                                                    start_level_, height_);
+    child_indicator_bits_ = BitvectorRank(rank_block_size, builder->getChildIndicatorBits(), num_items_per_level,
+                                          start_level_, height_);
+    louds_bits_ =
+        BitvectorSelect(select_sample_interval, builder->getLoudsBits(), num_items_per_level, start_level_, height_);
     // child_indicator_bits_ = new BitvectorRank(kRankBasicBlockSize, builder->getChildIndicatorBits(),
     //                                           num_items_per_level, start_level_, height_);
     // louds_bits_ =
@@ -288,7 +344,7 @@ LoudsSparse::LoudsSparse(const SuRFBuilder* builder) {
 
     if (builder->getSuffixType() == kNone) {
         // Modified by Shunsuke Kanda
-        suffixes_ = std::make_unique<BitvectorSuffix>();
+        suffixes_ = BitvectorSuffix();
         // suffixes_ = new BitvectorSuffix();
 
         // added by Kanda
@@ -304,9 +360,8 @@ LoudsSparse::LoudsSparse(const SuRFBuilder* builder) {
         for (level_t level = 0; level < height_; level++)
             num_suffix_bits_per_level.push_back(builder->getSuffixCounts()[level] * suffix_len);
         // Modified by Shunsuke Kanda
-        suffixes_ =
-            std::make_unique<BitvectorSuffix>(builder->getSuffixType(), hash_suffix_len, real_suffix_len,
-                                              builder->getSuffixes(), num_suffix_bits_per_level, start_level_, height_);
+        suffixes_ = BitvectorSuffix(builder->getSuffixType(), hash_suffix_len, real_suffix_len, builder->getSuffixes(),
+                                    num_suffix_bits_per_level, start_level_, height_);
         // suffixes_ = new BitvectorSuffix(builder->getSuffixType(), hash_suffix_len, real_suffix_len,
         //                                 builder->getSuffixes(), num_suffix_bits_per_level, start_level_, height_);
     }
@@ -318,17 +373,17 @@ bool LoudsSparse::lookupKey(const std::string& key, const position_t in_node_num
     level_t level = 0;
     for (level = start_level_; level < key.length(); level++) {
         // child_indicator_bits_->prefetch(pos);
-        if (!labels_->search((label_t)key[level], pos, nodeSize(pos))) return false;
+        if (!labels_.search((label_t)key[level], pos, nodeSize(pos))) return false;
 
         // if trie branch terminates
-        if (!child_indicator_bits_->readBit(pos)) return suffixes_->checkEquality(getSuffixPos(pos), key, level + 1);
+        if (!child_indicator_bits_.readBit(pos)) return suffixes_.checkEquality(getSuffixPos(pos), key, level + 1);
 
         // move to child
         node_num = getChildNodeNum(pos);
         pos = getFirstLabelPos(node_num);
     }
-    if ((labels_->read(pos) == kTerminator) && (!child_indicator_bits_->readBit(pos)))
-        return suffixes_->checkEquality(getSuffixPos(pos), key, level + 1);
+    if ((labels_.read(pos) == kTerminator) && (!child_indicator_bits_.readBit(pos)))
+        return suffixes_.checkEquality(getSuffixPos(pos), key, level + 1);
     return false;
 }
 
@@ -339,24 +394,26 @@ bool LoudsSparse::moveToKeyGreaterThan(const std::string& key, const bool inclus
     level_t level;
     for (level = start_level_; level < key.length(); level++) {
         position_t node_size = nodeSize(pos);
+        // search() moves pos past the terminator even if it fails
+        const position_t node_pos = pos;
         // if no exact match
-        if (!labels_->search((label_t)key[level], pos, node_size)) {
-            moveToLeftInNextSubtrie(pos, node_size, key[level], iter);
+        if (!labels_.search((label_t)key[level], pos, node_size)) {
+            moveToLeftInNextSubtrie(node_pos, node_size, key[level], iter);
             return false;
         }
 
         iter.append(key[level], pos);
 
         // if trie branch terminates
-        if (!child_indicator_bits_->readBit(pos)) return compareSuffixGreaterThan(pos, key, level + 1, inclusive, iter);
+        if (!child_indicator_bits_.readBit(pos)) return compareSuffixGreaterThan(pos, key, level + 1, inclusive, iter);
 
         // move to child
         node_num = getChildNodeNum(pos);
         pos = getFirstLabelPos(node_num);
     }
 
-    if ((labels_->read(pos) == kTerminator) && (!child_indicator_bits_->readBit(pos)) &&
-        !louds_bits_->readBit(pos + 1)) {
+    if ((labels_.read(pos) == kTerminator) && (!child_indicator_bits_.readBit(pos)) &&
+        !louds_bits_.readBit(pos + 1)) {
         iter.append(kTerminator, pos);
         iter.is_at_terminator_ = true;
         if (!inclusive) iter++;
@@ -375,43 +432,46 @@ bool LoudsSparse::moveToKeyGreaterThan(const std::string& key, const bool inclus
 
 uint64_t LoudsSparse::serializedSize() const {
     uint64_t size = sizeof(height_) + sizeof(start_level_) + sizeof(node_count_dense_) + sizeof(child_count_dense_) +
-                    labels_->serializedSize() + child_indicator_bits_->serializedSize() +
-                    louds_bits_->serializedSize() + suffixes_->serializedSize();
+                    labels_.serializedSize() + child_indicator_bits_.serializedSize() +
+                    louds_bits_.serializedSize() + suffixes_.serializedSize();
     sizeAlign(size);
     return size;
 }
 
+// The components are held in place, so sizeof(LoudsSparse) already covers them.
 uint64_t LoudsSparse::getMemoryUsage() const {
-    return (sizeof(this) + labels_->size() + child_indicator_bits_->size() + louds_bits_->size() + suffixes_->size());
+    return (sizeof(LoudsSparse) + labels_.size() + child_indicator_bits_.size() + louds_bits_.size() +
+            suffixes_.size()) -
+           (sizeof(labels_) + sizeof(child_indicator_bits_) + sizeof(louds_bits_) + sizeof(suffixes_));
 }
 
 position_t LoudsSparse::getChildNodeNum(const position_t pos) const {
-    return (child_indicator_bits_->rank(pos) + child_count_dense_);
+    return (child_indicator_bits_.rank(pos) + child_count_dense_);
 }
 
 position_t LoudsSparse::getFirstLabelPos(const position_t node_num) const {
-    return louds_bits_->select(node_num + 1 - node_count_dense_);
+    return louds_bits_.select(node_num + 1 - node_count_dense_);
 }
 
 position_t LoudsSparse::getLastLabelPos(const position_t node_num) const {
     position_t next_rank = node_num + 2 - node_count_dense_;
-    if (next_rank > louds_bits_->numOnes()) return (louds_bits_->numBits() - 1);
-    return (louds_bits_->select(next_rank) - 1);
+    if (next_rank > louds_bits_.numOnes()) return (louds_bits_.numBits() - 1);
+    return (louds_bits_.select(next_rank) - 1);
 }
 
 position_t LoudsSparse::getSuffixPos(const position_t pos) const {
-    return (pos - child_indicator_bits_->rank(pos));
+    return (pos - child_indicator_bits_.rank(pos));
 }
 
 position_t LoudsSparse::nodeSize(const position_t pos) const {
-    assert(louds_bits_->readBit(pos));
-    return louds_bits_->distanceToNextSetBit(pos);
+    assert(louds_bits_.readBit(pos));
+    return louds_bits_.distanceToNextSetBit(pos);
 }
 
 void LoudsSparse::moveToLeftInNextSubtrie(position_t pos, const position_t node_size, const label_t label,
                                           LoudsSparse::Iter& iter) const {
     // if no label is greater than key[level] in this node
-    if (!labels_->searchGreaterThan(label, pos, node_size)) {
+    if (!labels_.searchGreaterThan(label, pos, node_size)) {
         iter.append(pos + node_size - 1);
         return iter++;
     } else {
@@ -423,7 +483,7 @@ void LoudsSparse::moveToLeftInNextSubtrie(position_t pos, const position_t node_
 bool LoudsSparse::compareSuffixGreaterThan(const position_t pos, const std::string& key, const level_t level,
                                            const bool inclusive, LoudsSparse::Iter& iter) const {
     position_t suffix_pos = getSuffixPos(pos);
-    int compare = suffixes_->compare(suffix_pos, key, level);
+    int compare = suffixes_.compare(suffix_pos, key, level);
     if ((compare != kCouldBePositive) && (compare < 0)) {
         iter++;
         return false;
@@ -448,7 +508,7 @@ int LoudsSparse::Iter::compare(const std::string& key) const {
     int compare = iter_key.compare(key_sparse_same_length);
     if (compare != 0) return compare;
     position_t suffix_pos = trie_->getSuffixPos(pos_in_trie_[key_len_ - 1]);
-    return trie_->suffixes_->compare(suffix_pos, key_sparse, key_len_);
+    return trie_->suffixes_.compare(suffix_pos, key_sparse, key_len_);
 }
 
 std::string LoudsSparse::Iter::getKey() const {
@@ -459,10 +519,10 @@ std::string LoudsSparse::Iter::getKey() const {
 }
 
 int LoudsSparse::Iter::getSuffix(word_t* suffix) const {
-    if ((trie_->suffixes_->getType() == kReal) || (trie_->suffixes_->getType() == kMixed)) {
+    if ((trie_->suffixes_.getType() == kReal) || (trie_->suffixes_.getType() == kMixed)) {
         position_t suffix_pos = trie_->getSuffixPos(pos_in_trie_[key_len_ - 1]);
-        *suffix = trie_->suffixes_->readReal(suffix_pos);
-        return trie_->suffixes_->getRealSuffixLen();
+        *suffix = trie_->suffixes_.readReal(suffix_pos);
+        return trie_->suffixes_.getRealSuffixLen();
     }
     *suffix = 0;
     return 0;
@@ -470,11 +530,11 @@ int LoudsSparse::Iter::getSuffix(word_t* suffix) const {
 
 std::string LoudsSparse::Iter::getKeyWithSuffix(unsigned* bitlen) const {
     std::string iter_key = getKey();
-    if ((trie_->suffixes_->getType() == kReal) || (trie_->suffixes_->getType() == kMixed)) {
+    if ((trie_->suffixes_.getType() == kReal) || (trie_->suffixes_.getType() == kMixed)) {
         position_t suffix_pos = trie_->getSuffixPos(pos_in_trie_[key_len_ - 1]);
-        word_t suffix = trie_->suffixes_->readReal(suffix_pos);
+        word_t suffix = trie_->suffixes_.readReal(suffix_pos);
         if (suffix > 0) {
-            level_t suffix_len = trie_->suffixes_->getRealSuffixLen();
+            level_t suffix_len = trie_->suffixes_.getRealSuffixLen();
             *bitlen = suffix_len % 8;
             suffix <<= (64 - suffix_len);
             char* suffix_str = reinterpret_cast<char*>(&suffix);
@@ -492,7 +552,7 @@ std::string LoudsSparse::Iter::getKeyWithSuffix(unsigned* bitlen) const {
 
 void LoudsSparse::Iter::append(const position_t pos) {
     assert(key_len_ < key_.size());
-    key_[key_len_] = trie_->labels_->read(pos);
+    key_[key_len_] = trie_->labels_.read(pos);
     pos_in_trie_[key_len_] = pos;
     key_len_++;
 }
@@ -506,35 +566,35 @@ void LoudsSparse::Iter::append(const label_t label, const position_t pos) {
 
 void LoudsSparse::Iter::set(const level_t level, const position_t pos) {
     assert(level < key_.size());
-    key_[level] = trie_->labels_->read(pos);
+    key_[level] = trie_->labels_.read(pos);
     pos_in_trie_[level] = pos;
 }
 
 void LoudsSparse::Iter::setToFirstLabelInRoot() {
     assert(start_level_ == 0);
     pos_in_trie_[0] = 0;
-    key_[0] = trie_->labels_->read(0);
+    key_[0] = trie_->labels_.read(0);
 }
 
 void LoudsSparse::Iter::setToLastLabelInRoot() {
     assert(start_level_ == 0);
     pos_in_trie_[0] = trie_->getLastLabelPos(0);
-    key_[0] = trie_->labels_->read(pos_in_trie_[0]);
+    key_[0] = trie_->labels_.read(pos_in_trie_[0]);
 }
 
 void LoudsSparse::Iter::moveToLeftMostKey() {
     if (key_len_ == 0) {
         position_t pos = trie_->getFirstLabelPos(start_node_num_);
-        label_t label = trie_->labels_->read(pos);
+        label_t label = trie_->labels_.read(pos);
         append(label, pos);
     }
 
     level_t level = key_len_ - 1;
     position_t pos = pos_in_trie_[level];
-    label_t label = trie_->labels_->read(pos);
+    label_t label = trie_->labels_.read(pos);
 
-    if (!trie_->child_indicator_bits_->readBit(pos)) {
-        if ((label == kTerminator) && !trie_->louds_bits_->readBit(pos + 1)) is_at_terminator_ = true;
+    if (!trie_->child_indicator_bits_.readBit(pos)) {
+        if ((label == kTerminator) && !trie_->louds_bits_.readBit(pos + 1)) is_at_terminator_ = true;
         is_valid_ = true;
         return;
     }
@@ -542,11 +602,11 @@ void LoudsSparse::Iter::moveToLeftMostKey() {
     while (level < trie_->getHeight()) {
         position_t node_num = trie_->getChildNodeNum(pos);
         pos = trie_->getFirstLabelPos(node_num);
-        label = trie_->labels_->read(pos);
+        label = trie_->labels_.read(pos);
         // if trie branch terminates
-        if (!trie_->child_indicator_bits_->readBit(pos)) {
+        if (!trie_->child_indicator_bits_.readBit(pos)) {
             append(label, pos);
-            if ((label == kTerminator) && !trie_->louds_bits_->readBit(pos + 1)) is_at_terminator_ = true;
+            if ((label == kTerminator) && !trie_->louds_bits_.readBit(pos + 1)) is_at_terminator_ = true;
             is_valid_ = true;
             return;
         }
@@ -560,16 +620,16 @@ void LoudsSparse::Iter::moveToRightMostKey() {
     if (key_len_ == 0) {
         position_t pos = trie_->getFirstLabelPos(start_node_num_);
         pos = trie_->getLastLabelPos(start_node_num_);
-        label_t label = trie_->labels_->read(pos);
+        label_t label = trie_->labels_.read(pos);
         append(label, pos);
     }
 
     level_t level = key_len_ - 1;
     position_t pos = pos_in_trie_[level];
-    label_t label = trie_->labels_->read(pos);
+    label_t label = trie_->labels_.read(pos);
 
-    if (!trie_->child_indicator_bits_->readBit(pos)) {
-        if ((label == kTerminator) && !trie_->louds_bits_->readBit(pos + 1)) is_at_terminator_ = true;
+    if (!trie_->child_indicator_bits_.readBit(pos)) {
+        if ((label == kTerminator) && !trie_->louds_bits_.readBit(pos + 1)) is_at_terminator_ = true;
         is_valid_ = true;
         return;
     }
@@ -577,11 +637,11 @@ void LoudsSparse::Iter::moveToRightMostKey() {
     while (level < trie_->getHeight()) {
         position_t node_num = trie_->getChildNodeNum(pos);
         pos = trie_->getLastLabelPos(node_num);
-        label = trie_->labels_->read(pos);
+        label = trie_->labels_.read(pos);
         // if trie branch terminates
-        if (!trie_->child_indicator_bits_->readBit(pos)) {
+        if (!trie_->child_indicator_bits_.readBit(pos)) {
             append(label, pos);
-            if ((label == kTerminator) && !trie_->louds_bits_->readBit(pos + 1)) is_at_terminator_ = true;
+            if ((label == kTerminator) && !trie_->louds_bits_.readBit(pos + 1)) is_at_terminator_ = true;
             is_valid_ = true;
             return;
         }
@@ -596,7 +656,7 @@ void LoudsSparse::Iter::operator++(int) {
     is_at_terminator_ = false;
     position_t pos = pos_in_trie_[key_len_ - 1];
     pos++;
-    while (pos >= trie_->louds_bits_->numBits() || trie_->louds_bits_->readBit(pos)) {
+    while (pos >= trie_->louds_bits_.numBits() || trie_->louds_bits_.readBit(pos)) {
         key_len_--;
         if (key_len_ == 0) {
             is_valid_ = false;
@@ -617,7 +677,7 @@ void LoudsSparse::Iter::operator--(int) {
         is_valid_ = false;
         return;
     }
-    while (trie_->louds_bits_->readBit(pos)) {
+    while (trie_->louds_bits_.readBit(pos)) {
         key_len_--;
         if (key_len_ == 0) {
             is_valid_ = false;
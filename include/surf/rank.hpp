@@ -37,6 +37,9 @@ class BitvectorRank : public Bitvector {
 
     ~BitvectorRank() {}
 
+    BitvectorRank(BitvectorRank&&) = default;
+    BitvectorRank& operator=(BitvectorRank&&) = default;
+
     // Counts the number of 1's in the bitvector up to position pos.
     // pos is zero-based; count is one-based.
     // E.g., for bitvector: 100101000, rank(3) = 2
@@ -112,6 +115,13 @@ class BitvectorRank : public Bitvector {
         loadValue(is, basic_block_size_);
         loadArray(is, rank_lut_, num_bits_ / basic_block_size_ + 1);
     }
+    size_t arenaBytes() const {
+        return Bitvector::arenaBytes() + Arena::footprint<position_t>(num_bits_ / basic_block_size_ + 1);
+    }
+    void moveToArena(Arena& arena) {
+        Bitvector::moveToArena(arena);
+        arena.relocate(rank_lut_, num_bits_ / basic_block_size_ + 1);
+    }
 
   private:
     void initRankLut() {
@@ -119,7 +129,7 @@ class BitvectorRank : public Bitvector {
         position_t num_blocks = num_bits_ / basic_block_size_ + 1;
 
         // Modified by Shunsuke Kanda
-        rank_lut_ = std::make_unique<position_t[]>(num_blocks);
+        rank_lut_ = makeArray<position_t>(num_blocks);
         // rank_lut_ = new position_t[num_blocks];
 
         position_t cumu_rank = 0;
@@ -132,7 +142,7 @@ class BitvectorRank : public Bitvector {
 
     // Modified by Shunsuke Kanda
     position_t basic_block_size_ = 0;
-    std::unique_ptr<position_t[]> rank_lut_;
+    array_ptr<position_t> rank_lut_;
     // position_t* rank_lut_;  // rank look-up table
 };
 
@@ -38,6 +38,9 @@ class BitvectorSelect : public Bitvector {
 
     ~BitvectorSelect() {}
 
+    BitvectorSelect(BitvectorSelect&&) = default;
+    BitvectorSelect& operator=(BitvectorSelect&&) = default;
+
     // Returns the postion of the rank-th 1 bit.
     // posistion is zero-based; rank is one-based.
     // E.g., for bitvector: 100101000, select(3) = 5
@@ -151,7 +154,7 @@ class BitvectorSelect : public Bitvector {
 
         num_ones_ = cumu_ones_upto_word;
         position_t num_samples = select_lut_vector.size();
-        select_lut_ = std::make_unique<position_t[]>(num_samples);
+        select_lut_ = makeArray<position_t>(num_samples);
         // select_lut_ = new position_t[num_samples];
         for (position_t i = 0; i < num_samples; i++) select_lut_[i] = select_lut_vector[i];
     }
@@ -170,12 +173,19 @@ class BitvectorSelect : public Bitvector {
         loadValue(is, num_ones_);
         loadArray(is, select_lut_, num_ones_ / sample_interval_ + 1);
     }
+    size_t arenaBytes() const {
+        return Bitvector::arenaBytes() + Arena::footprint<position_t>(num_ones_ / sample_interval_ + 1);
+    }
+    void moveToArena(Arena& arena) {
+        Bitvector::moveToArena(arena);
+        arena.relocate(select_lut_, num_ones_ / sample_interval_ + 1);
+    }
 
   private:
     // Modified by Shunsuke Kanda
     position_t sample_interval_ = 0;
     position_t num_ones_ = 0;
-    std::unique_ptr<position_t[]> select_lut_;
+    array_ptr<position_t> select_lut_;
     // position_t* select_lut_;  // select look-up table
 };
 
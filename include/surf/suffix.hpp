@@ -50,24 +50,24 @@ class BitvectorSuffix : public Bitvector {
         return suffix;
     }
 
+    // A key with less than len bits left is padded with zeros (the terminator sorts first) instead
+    // of having no suffix, which would make compare() order a short query before every stored
+    // suffix and thus lookupRange miss keys.
     static word_t constructRealSuffix(const std::string& key, const level_t level, const level_t len) {
-        if (key.length() < level || ((key.length() - level) * 8) < len) return 0;
+        if (key.length() < level) return 0;
+        auto byte_at = [&](const position_t i) -> word_t {
+            return (level + i < key.length()) ? (word_t)(uint8_t)key[level + i] : 0;
+        };
         word_t suffix = 0;
         level_t num_complete_bytes = len / 8;
-        if (num_complete_bytes > 0) {
-            suffix += (word_t)(label_t)key[level];
-            for (position_t i = 1; i < num_complete_bytes; i++) {
-                suffix <<= 8;
-                suffix += (word_t)(uint8_t)key[level + i];
-            }
+        for (position_t i = 0; i < num_complete_bytes; i++) {
+            suffix <<= 8;
+            suffix += byte_at(i);
         }
         level_t offset = len % 8;
         if (offset > 0) {
             suffix <<= offset;
-            word_t remaining_bits = 0;
-            remaining_bits = (word_t)(uint8_t)key[level + num_complete_bytes];
-            remaining_bits >>= (8 - offset);
-            suffix += remaining_bits;
+            suffix += (byte_at(num_complete_bytes) >> (8 - offset));
         }
         return suffix;
     }
@@ -212,7 +212,8 @@ word_t BitvectorSuffix::read(const position_t idx) const {
     position_t word_id = bit_pos / kWordSize;
     position_t offset = bit_pos & (kWordSize - 1);
     word_t ret_word = (bits_[word_id] << offset) >> (kWordSize - suffix_len);
-    if (offset + suffix_len > kWordSize) ret_word += (bits_[word_id + 1] >> (kWordSize - offset - suffix_len));
+    // the bits in the next word are the remaining low bits of the suffix
+    if (offset + suffix_len > kWordSize) ret_word += (bits_[word_id + 1] >> (2 * kWordSize - offset - suffix_len));
     return ret_word;
 }
 
@@ -228,8 +229,7 @@ bool BitvectorSuffix::checkEquality(const position_t idx, const std::string& key
     if (type_ == kReal) {
         // if no suffix info for the stored key
         if (stored_suffix == 0) return true;
-        // if the querying key is shorter than the stored key
-        if (key.length() < level || ((key.length() - level) * 8) < real_suffix_len_) return false;
+        // a querying key shorter than the stored key is padded (see constructRealSuffix)
     }
     word_t querying_suffix = constructSuffix(type_, key, hash_suffix_len_, level, real_suffix_len_);
     return (stored_suffix == querying_suffix);
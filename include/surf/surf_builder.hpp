@@ -37,6 +37,13 @@ class SuRFBuilder {
     // REQUIRED: provided key list must be sorted.
     void build(const std::vector<std::string>& keys);
 
+    // The steps of build() for keys given one at a time (see fst::TrieBuilder).
+    // insertKey adds key, given the next distinct key (empty for the last one), and returns
+    // the level at which key becomes unique; its suffix is the last one of level - 1.
+    // finish() is called once after the last key.
+    level_t insertKey(const std::string& key, const std::string& next_key);
+    void finish();
+
     static bool readBit(const std::vector<word_t>& bits, const position_t pos) {
         assert(pos < (bits.size() * kWordSize));
         position_t word_id = pos / kWordSize;
@@ -185,22 +192,32 @@ class SuRFBuilder {
 void SuRFBuilder::build(const std::vector<std::string>& keys) {
     assert(keys.size() > 0);
     buildSparse(keys);
+    finish();
+}
+
+level_t SuRFBuilder::insertKey(const std::string& key, const std::string& next_key) {
+    level_t level = skipCommonPrefix(key);
+    level = insertKeyBytesToTrieUntilUnique(key, next_key, level);
+    insertSuffix(key, level);
+    return level;
+}
+
+void SuRFBuilder::finish() {
     if (include_dense_) {
         determineCutoffLevel();
         buildDense();
     }
 }
 
+// Each distinct key is added by insertKey, as in fst::TrieBuilder.
 void SuRFBuilder::buildSparse(const std::vector<std::string>& keys) {
     for (position_t i = 0; i < keys.size(); i++) {
-        level_t level = skipCommonPrefix(keys[i]);
         position_t curpos = i;
         while ((i + 1 < keys.size()) && isSameKey(keys[curpos], keys[i + 1])) i++;
         if (i < keys.size() - 1)
-            level = insertKeyBytesToTrieUntilUnique(keys[curpos], keys[i + 1], level);
+            insertKey(keys[curpos], keys[i + 1]);
         else  // for last key, there is no successor key in the list
-            level = insertKeyBytesToTrieUntilUnique(keys[curpos], std::string(), level);
-        insertSuffix(keys[curpos], level);
+            insertKey(keys[curpos], std::string());
     }
 }
 
@@ -294,6 +311,11 @@ void SuRFBuilder::insertKeyByte(const char c, const level_t level, const bool is
 
 inline void SuRFBuilder::storeSuffix(const level_t level, const word_t suffix) {
     level_t suffix_len = getSuffixLen();
+    // nothing is stored without suffix bits (kNone), where the shifts below would be by kWordSize
+    if (suffix_len == 0) {
+        suffix_counts_[level - 1]++;
+        return;
+    }
     position_t pos = suffix_counts_[level - 1] * suffix_len;
     assert(pos <= (suffixes_[level - 1].size() * kWordSize));
     if (pos == (suffixes_[level - 1].size() * kWordSize)) suffixes_[level - 1].push_back(0);
@@ -0,0 +1,188 @@
+//  Instrumentation policies for the trie walk.
+//  The traversal code takes the policy as a template parameter and reports events to it.
+//  NoStats has empty members, so the instrumented code compiles to the same code as before.
+//  TraversalStats counts the events of each query and aggregates them into histograms;
+//  use one object per thread and merge() them to get the totals.
+//
+#ifndef TRAVERSALSTATS_H_
+#define TRAVERSALSTATS_H_
+
+#include <stdint.h>
+
+#include <algorithm>
+#include <array>
+#include <ostream>
+
+namespace surf {
+
+enum LabelSearchKernel { kLinearSearch = 0, kBinarySearch = 1, kSimdSearch = 2 };
+
+struct NoStats {
+    void beginQuery() {}
+    void endQuery() {}
+    void onRootJump() {}
+    void onDenseLevel() {}
+    void onSparseLevel() {}
+    void onRank(const uint64_t = 1) {}
+    void onSelect(const uint64_t = 1) {}
+    void onLabelSearch(const LabelSearchKernel) {}
+    void onTailBytes(const uint64_t) {}
+    void onBloomReject() {}
+    void onFingerprintReject() {}
+    void onInlineTail() {}
+};
+
+// Histogram of one counter over queries. Bin i counts the queries with value i;
+// the last bin also counts larger values.
+class Histogram {
+  public:
+    static const uint32_t kNumBins = 64;
+
+    void add(const uint64_t value) {
+        ++bins_[std::min<uint64_t>(value, kNumBins - 1)];
+        ++count_;
+        sum_ += value;
+        max_ = std::max(max_, value);
+    }
+    void merge(const Histogram& other) {
+        for (uint32_t i = 0; i < kNumBins; ++i) bins_[i] += other.bins_[i];
+        count_ += other.count_;
+        sum_ += other.sum_;
+        max_ = std::max(max_, other.max_);
+    }
+
+    uint64_t getBin(const uint32_t i) const {
+        return bins_[i];
+    }
+    uint64_t getCount() const {
+        return count_;
+    }
+    uint64_t getSum() const {
+        return sum_;
+    }
+    uint64_t getMax() const {
+        return max_;
+    }
+    double getMean() const {
+        return count_ != 0 ? double(sum_) / count_ : 0.0;
+    }
+
+    // Writes a JSON object; trailing empty bins are omitted.
+    void dump(std::ostream& os) const {
+        uint32_t num_bins = kNumBins;
+        while (num_bins != 0 && bins_[num_bins - 1] == 0) --num_bins;
+        os << "{\"count\": " << count_ << ", \"sum\": " << sum_ << ", \"mean\": " << getMean()
+           << ", \"max\": " << max_ << ", \"bins\": [";
+        for (uint32_t i = 0; i < num_bins; ++i) os << (i != 0 ? ", " : "") << bins_[i];
+        os << "]}";
+    }
+
+  private:
+    std::array<uint64_t, kNumBins> bins_ = {};
+    uint64_t count_ = 0;
+    uint64_t sum_ = 0;
+    uint64_t max_ = 0;
+};
+
+class TraversalStats {
+  public:
+    enum Counter {
+        kRootJumps = 0,  // lookups resolved through the root jump table
+        kDenseLevels,  // levels walked in LoudsDense
+        kSparseLevels,  // levels walked in LoudsSparse
+        kRankCalls,
+        kSelectCalls,
+        kLinearSearches,  // LabelVector search kernels
+        kBinarySearches,
+        kSimdSearches,
+        kTailBytes,  // tail bytes compared
+        kBloomRejects,  // lookups rejected by the Bloom filter
+        kFingerprintRejects,  // lookups rejected by the fingerprint of a leaf
+        kInlineTails,  // inline tails compared
+        kNumCounters
+    };
+
+    static const char* getCounterName(const Counter counter) {
+        static const char* names[kNumCounters] = {
+            "root_jumps",          "dense_levels",    "sparse_levels", "rank_calls", "select_calls",
+            "linear_searches",     "binary_searches", "simd_searches", "tail_bytes", "bloom_rejects",
+            "fingerprint_rejects", "inline_tails",
+        };
+        return names[counter];
+    }
+
+    void beginQuery() {
+        counts_.fill(0);
+    }
+    void endQuery() {
+        for (uint32_t i = 0; i < kNumCounters; ++i) histograms_[i].add(counts_[i]);
+    }
+
+    void onRootJump() {
+        ++counts_[kRootJumps];
+    }
+    void onDenseLevel() {
+        ++counts_[kDenseLevels];
+    }
+    void onSparseLevel() {
+        ++counts_[kSparseLevels];
+    }
+    void onRank(const uint64_t n = 1) {
+        counts_[kRankCalls] += n;
+    }
+    void onSelect(const uint64_t n = 1) {
+        counts_[kSelectCalls] += n;
+    }
+    void onLabelSearch(const LabelSearchKernel kernel) {
+        ++counts_[kLinearSearches + kernel];
+    }
+    void onTailBytes(const uint64_t n) {
+        counts_[kTailBytes] += n;
+    }
+    void onBloomReject() {
+        ++counts_[kBloomRejects];
+    }
+    void onFingerprintReject() {
+        ++counts_[kFingerprintRejects];
+    }
+    void onInlineTail() {
+        ++counts_[kInlineTails];
+    }
+
+    uint64_t getNumQueries() const {
+        return histograms_[0].getCount();
+    }
+    // Counter values of the last query
+    uint64_t getLastCount(const Counter counter) const {
+        return counts_[counter];
+    }
+    const Histogram& getHistogram(const Counter counter) const {
+        return histograms_[counter];
+    }
+
+    void merge(const TraversalStats& other) {
+        for (uint32_t i = 0; i < kNumCounters; ++i) histograms_[i].merge(other.histograms_[i]);
+    }
+    void reset() {
+        counts_.fill(0);
+        histograms_.fill(Histogram());
+    }
+
+    // Writes the aggregated histograms as one JSON object keyed by counter name.
+    void dump(std::ostream& os) const {
+        os << "{\"num_queries\": " << getNumQueries();
+        for (uint32_t i = 0; i < kNumCounters; ++i) {
+            os << ", \"" << getCounterName(Counter(i)) << "\": ";
+            histograms_[i].dump(os);
+        }
+        os << "}";
+    }
+
+  private:
+    std::array<uint64_t, kNumCounters> counts_ = {};
+    std::array<Histogram, kNumCounters> histograms_ = {};
+};
+
+}  // namespace surf
+
+#endif  // TRAVERSALSTATS_H_
@@ -1,12 +1,21 @@
 #define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#define DOCTEST_CONFIG_NO_POSIX_SIGNALS  // SIGSTKSZ is no longer a constant on recent glibc
 
 #include <algorithm>
 #include <iostream>
 #include <random>
+#include <set>
+#include <sstream>
 #include <string>
+#include <thread>
 #include <vector>
 
 #include <fst.hpp>
+#include <fst/filter.hpp>
+#include <fst/hot_key_cache.hpp>
+#include <fst/merge.hpp>
+#include <fst/top_k.hpp>
+#include <fst/updatable_trie.hpp>
 
 #include "doctest/doctest.h"
 
@@ -117,3 +126,899 @@ TEST_CASE("Test fst::Trie (random 10K, A--Z)") {
     test_exact_search(trie, keys, others);
     test_io(trie, keys, others);
 }
+
+TEST_CASE("Test fst::Trie with build config") {
+    auto keys = to_unique_vec(make_random_keys(10000, 1, 30, 'A', 'Z'));
+    auto others = extract_keys(keys);
+
+    const fst::Trie base(keys, true, 16);
+    for (fst::position_t rank_block_size : {64, 256, 2048}) {
+        for (fst::position_t select_sample_interval : {1, 37, 512}) {
+            fst::Config config;
+            config.sparse_dense_ratio = 16;
+            config.rank_block_size = rank_block_size;
+            config.select_sample_interval = select_sample_interval;
+            fst::Trie trie(keys, config);
+            REQUIRE_EQ(trie.getSparseStartLevel(), base.getSparseStartLevel());
+            for (size_t i = 0; i < keys.size(); i++) {
+                REQUIRE_EQ(trie.exactSearch(keys[i]), base.exactSearch(keys[i]));
+            }
+            test_exact_search(trie, keys, others);
+            test_io(trie, keys, others);
+        }
+    }
+}
+
+TEST_CASE("Test fst::TrieBuilder") {
+    auto keys = to_unique_vec(make_random_keys(10000, 1, 30, 'A', 'C'));
+    auto others = extract_keys(keys);
+
+    fst::Config config;
+    config.fingerprint_bits = 8;
+    config.inline_tail_bytes = 2;
+    config.bloom_bits_per_key = 10;
+    fst::TrieBuilder builder(config);
+    for (const auto& key : keys) {
+        builder.add(key);
+        builder.add(key);  // ignored
+    }
+    const fst::Trie trie = builder.build();
+    test_exact_search(trie, keys, others);
+
+    // key IDs are the same as those of Trie(keys, config), and each is used once
+    const fst::Trie base(keys, config);
+    std::vector<bool> used(keys.size(), false);
+    for (const auto& key : keys) {
+        const fst::position_t key_id = trie.exactSearch(key);
+        REQUIRE_EQ(key_id, base.exactSearch(key));
+        REQUIRE(!used[key_id]);
+        used[key_id] = true;
+    }
+    REQUIRE_EQ(trie.getSuffixBytes(), base.getSuffixBytes());
+
+    REQUIRE_EQ(fst::TrieBuilder().build().getNumKeys(), 0);
+}
+
+TEST_CASE("Test fst::TrieBuilder with snapshots") {
+    // keys sharing long prefixes, as time-ordered IDs do
+    auto keys = to_unique_vec(make_random_keys(10000, 1, 20, 'A', 'C'));
+    for (size_t i = 0; i < keys.size(); i++) {
+        keys[i] = std::to_string(1000000 + i / 100) + keys[i];
+    }
+
+    fst::Config config;
+    config.fingerprint_bits = 8;
+    config.inline_tail_bytes = 2;
+    config.rank_select = true;
+    fst::TrieBuilder builder(config);
+    REQUIRE_EQ(builder.snapshot().getNumKeys(), 0);
+
+    size_t num_added = 0;
+    for (size_t batch_size : {1, 10, 1000, 1, 3000, 0}) {
+        const size_t end = batch_size != 0 ? num_added + batch_size : keys.size();  // 0 for the rest
+        while (num_added < end) {
+            builder.add(keys[num_added++]);
+        }
+        REQUIRE_EQ(builder.getNumKeys(), num_added);
+
+        const std::vector<std::string> added(keys.begin(), keys.begin() + num_added);
+        const fst::Trie trie = builder.snapshot();
+        const fst::Trie base(added, config);
+        REQUIRE_EQ(trie.getNumKeys(), num_added);
+        REQUIRE_EQ(trie.getNumNodes(), base.getNumNodes());
+        for (size_t i = 0; i < keys.size(); i++) {
+            REQUIRE_EQ(trie.exactSearch(keys[i]), i < num_added ? base.exactSearch(keys[i]) : fst::kNotFound);
+        }
+        for (fst::position_t i = 0; i < num_added; i++) {
+            REQUIRE_EQ(trie.select(i).getKey(), keys[i]);
+        }
+        REQUIRE_EQ(trie.countPrefix(keys[num_added / 2].substr(0, 6)), base.countPrefix(keys[num_added / 2].substr(0, 6)));
+    }
+    REQUIRE_EQ(num_added, keys.size());
+
+    const fst::Trie trie = builder.build();
+    test_exact_search(trie, keys, {});
+    for (fst::position_t i = 0; i < keys.size(); i++) {
+        REQUIRE_EQ(trie.rank(keys[i]), i);
+    }
+}
+
+TEST_CASE("Test fst::mergeTries") {
+    auto keys = to_unique_vec(make_random_keys(10000, 1, 30, 'A', 'C'));
+    auto others = extract_keys(keys);
+
+    // overlapping inputs, one of which has deleted keys and one is empty
+    std::vector<std::vector<std::string>> inputs(4);
+    for (size_t i = 0; i < keys.size(); i++) {
+        inputs[i % 3].push_back(keys[i]);
+        if (i % 4 == 0) inputs[(i + 1) % 3].push_back(keys[i]);
+    }
+    std::vector<fst::Trie> tries;
+    for (const auto& input : inputs) {
+        tries.emplace_back(input);
+    }
+    const fst::position_t deleted_id = tries[1].exactSearch(inputs[1][0]);
+    REQUIRE(tries[1].erase(inputs[1][0]));
+    std::vector<const fst::Trie*> trie_ptrs;
+    for (const auto& trie : tries) {
+        trie_ptrs.push_back(&trie);
+    }
+
+    fst::Config config;
+    config.rank_select = true;
+    const auto result = fst::mergeTries(trie_ptrs, config);
+    const fst::Trie& merged = result.trie;
+
+    std::vector<std::string> expected = keys;
+    if (std::find(inputs[0].begin(), inputs[0].end(), inputs[1][0]) == inputs[0].end() &&
+        std::find(inputs[2].begin(), inputs[2].end(), inputs[1][0]) == inputs[2].end()) {
+        expected.erase(std::find(expected.begin(), expected.end(), inputs[1][0]));
+    }
+    test_exact_search(merged, expected, others);
+    for (fst::position_t i = 0; i < expected.size(); i++) {
+        REQUIRE_EQ(merged.rank(expected[i]), i);
+    }
+
+    REQUIRE_EQ(result.key_id_maps.size(), inputs.size());
+    for (size_t j = 0; j < inputs.size(); j++) {
+        REQUIRE_EQ(result.key_id_maps[j].size(), tries[j].getNumKeyIds());
+        for (const auto& key : inputs[j]) {
+            const fst::position_t key_id = tries[j].exactSearch(key);
+            if (key_id != fst::kNotFound) {
+                REQUIRE_EQ(result.key_id_maps[j][key_id], merged.exactSearch(key));
+            }
+        }
+    }
+    REQUIRE_EQ(result.key_id_maps[1][deleted_id], fst::kNotFound);
+
+    REQUIRE_EQ(fst::mergeTries({}).trie.getNumKeys(), 0);
+}
+
+TEST_CASE("Test fst::UpdatableTrie") {
+    auto keys = to_unique_vec(make_random_keys(10000, 1, 30, 'A', 'Z'));
+    auto others = extract_keys(keys, 0.3);
+
+    fst::UpdatableTrie trie(keys, fst::Config(), 1000);
+    std::set<std::string> expected(keys.begin(), keys.end());
+    auto check = [&]() {
+        for (const auto& key : keys) {
+            REQUIRE_EQ(trie.contains(key), expected.count(key) != 0);
+        }
+        for (const auto& key : others) {
+            REQUIRE_EQ(trie.contains(key), expected.count(key) != 0);
+        }
+    };
+
+    // updates are visible at once, whether buffered, being merged or merged
+    for (size_t i = 0; i < others.size(); i++) {
+        trie.insert(others[i]);
+        expected.insert(others[i]);
+        if (i % 3 == 0) {
+            trie.erase(keys[i]);
+            expected.erase(keys[i]);
+        }
+    }
+    check();
+    trie.startMerge();  // false if the updates above have started one already
+    check();
+    trie.waitForMerge();  // merges whatever is left in the buffer
+    check();
+    REQUIRE_EQ(trie.getNumBufferedUpdates(), 0);
+    REQUIRE_EQ(trie.getTrie()->getNumKeys(), expected.size());
+    REQUIRE(!trie.startMerge());
+
+    // readers run during the merges; keys[i] for i % 7 == 0 are erased meanwhile, and the
+    // others keep their membership
+    std::vector<bool> is_member(keys.size());
+    for (size_t i = 0; i < keys.size(); i++) {
+        is_member[i] = expected.count(keys[i]) != 0;
+    }
+    std::vector<std::thread> threads;
+    std::vector<int> errors(4, 0);
+    for (int t = 0; t < 4; t++) {
+        threads.emplace_back([&, t]() {
+            for (size_t i = t; i < keys.size(); i += 4) {
+                errors[t] += i % 7 != 0 && trie.contains(keys[i]) != is_member[i];
+            }
+        });
+    }
+    for (size_t i = 0; i < keys.size(); i += 7) {
+        trie.erase(keys[i]);
+        expected.erase(keys[i]);
+    }
+    for (auto& th : threads) {
+        th.join();
+    }
+    for (int t = 0; t < 4; t++) {
+        REQUIRE_EQ(errors[t], 0);
+    }
+    trie.waitForMerge();
+    check();
+    REQUIRE_EQ(trie.getNumBufferedUpdates(), 0);
+    REQUIRE_EQ(trie.getTrie()->getNumKeys(), expected.size());
+
+    // everything can be erased
+    fst::UpdatableTrie empty;
+    REQUIRE(!empty.contains("A"));
+    empty.insert("A");
+    empty.waitForMerge();
+    REQUIRE(empty.contains("A"));
+    empty.erase("A");
+    empty.waitForMerge();
+    REQUIRE(!empty.contains("A"));
+    REQUIRE_EQ(empty.getTrie()->getNumKeys(), 0);
+}
+
+TEST_CASE("Test fst::Trie with Bloom filter") {
+    auto keys = to_unique_vec(make_random_keys(10000, 1, 30, 'A', 'Z'));
+    auto others = extract_keys(keys);
+
+    const fst::Trie base(keys, true, 16);
+    REQUIRE(!base.hasBloomFilter());
+    for (uint32_t bits_per_key : {1, 10}) {
+        fst::Config config;
+        config.sparse_dense_ratio = 16;
+        config.bloom_bits_per_key = bits_per_key;
+        fst::Trie trie(keys, config);
+        REQUIRE(trie.hasBloomFilter());
+        REQUIRE_GE(trie.getMemoryUsage(), base.getMemoryUsage() + keys.size() * bits_per_key / 8);
+        for (size_t i = 0; i < keys.size(); i++) {
+            REQUIRE_EQ(trie.exactSearch(keys[i]), base.exactSearch(keys[i]));
+        }
+        test_exact_search(trie, keys, others);
+        test_io(trie, keys, others);
+
+        surf::TraversalStats stats;
+        for (const auto& other : others) {
+            REQUIRE_EQ(trie.exactSearch(other, stats), fst::kNotFound);
+        }
+        const uint64_t num_rejects = stats.getHistogram(surf::TraversalStats::kBloomRejects).getSum();
+        REQUIRE_GT(num_rejects, 0);
+        if (bits_per_key == 10) {
+            REQUIRE_GT(num_rejects, others.size() * 9 / 10);
+        }
+
+        trie.packIntoArena();
+        test_exact_search(trie, keys, others);
+    }
+}
+
+TEST_CASE("Test fst::Trie with fingerprints") {
+    auto keys = to_unique_vec(make_random_keys(10000, 1, 30, 'A', 'Z'));
+    auto others = extract_keys(keys);
+
+    const fst::Trie base(keys, true, 16);
+    REQUIRE_EQ(base.getFingerprintBits(), 0);
+    for (uint32_t fingerprint_bits : {8, 16, 32}) {
+        fst::Config config;
+        config.sparse_dense_ratio = 16;
+        config.fingerprint_bits = fingerprint_bits;
+        fst::Trie trie(keys, config);
+        REQUIRE_GT(trie.getFingerprintBits(), 0);
+        REQUIRE_LE(trie.getFingerprintBits(), fingerprint_bits);
+        for (size_t i = 0; i < keys.size(); i++) {
+            REQUIRE_EQ(trie.exactSearch(keys[i]), base.exactSearch(keys[i]));
+        }
+        test_exact_search(trie, keys, others);
+        test_io(trie, keys, others);
+
+        auto it = trie.begin();
+        for (size_t i = 0; i < keys.size(); i++, it++) {
+            REQUIRE(it.isValid());
+            REQUIRE_EQ(it.getKey(), keys[i]);
+        }
+
+        surf::TraversalStats stats;
+        uint64_t num_leaves = 0;
+        for (const auto& other : others) {
+            REQUIRE_EQ(trie.exactSearch(other, stats), fst::kNotFound);
+            num_leaves += stats.getLastCount(surf::TraversalStats::kTailBytes) != 0 ||
+                          stats.getLastCount(surf::TraversalStats::kFingerprintRejects) != 0;
+        }
+        // the misses reaching a leaf mostly end at the fingerprint
+        const uint64_t num_rejects = stats.getHistogram(surf::TraversalStats::kFingerprintRejects).getSum();
+        REQUIRE_GT(num_rejects, num_leaves * 9 / 10);
+    }
+}
+
+TEST_CASE("Test fst::Trie with inline tails") {
+    auto keys = to_unique_vec(make_random_keys(10000, 1, 12, 'A', 'Z'));
+    auto others = extract_keys(keys);
+
+    const fst::Trie base(keys, true, 16);
+    REQUIRE_EQ(base.getInlineTailBytes(), 0);
+    for (uint32_t inline_tail_bytes : {1, 3, 8}) {
+        for (uint32_t fingerprint_bits : {0, 8}) {
+            fst::Config config;
+            config.sparse_dense_ratio = 16;
+            config.inline_tail_bytes = inline_tail_bytes;
+            config.fingerprint_bits = fingerprint_bits;
+            fst::Trie trie(keys, config);
+            REQUIRE_EQ(trie.getInlineTailBytes(), std::min(inline_tail_bytes, fst::kMaxInlineTailBytes));
+            REQUIRE_LE(trie.getSuffixBytes(), base.getSuffixBytes());  // short tails may be shared anyway
+            if (inline_tail_bytes >= 3) {
+                REQUIRE_LT(trie.getSuffixBytes(), base.getSuffixBytes());
+            }
+            for (size_t i = 0; i < keys.size(); i++) {
+                REQUIRE_EQ(trie.exactSearch(keys[i]), base.exactSearch(keys[i]));
+            }
+            test_exact_search(trie, keys, others);
+            test_io(trie, keys, others);
+
+            auto it = trie.begin();
+            for (size_t i = 0; i < keys.size(); i++, it++) {
+                REQUIRE(it.isValid());
+                REQUIRE_EQ(it.getKey(), keys[i]);
+            }
+            for (size_t i = 0; i < others.size(); i++) {
+                std::vector<fst::position_t> expected, actual;
+                base.commonPrefixSearch(others[i], [&](fst::position_t id, size_t) { expected.push_back(id); });
+                trie.commonPrefixSearch(others[i], [&](fst::position_t id, size_t) { actual.push_back(id); });
+                REQUIRE_EQ(actual, expected);
+            }
+
+            surf::TraversalStats stats;
+            for (const auto& key : keys) {
+                trie.exactSearch(key, stats);
+            }
+            REQUIRE_GT(stats.getHistogram(surf::TraversalStats::kInlineTails).getSum(), 0);
+        }
+    }
+}
+
+TEST_CASE("Test fst::Trie ordered traversals") {
+    auto keys = to_unique_vec(make_random_keys(10000, 1, 10, 'A', 'D'));
+    auto others = extract_keys(keys);
+    others.push_back("");
+    others.push_back("Z");
+
+    for (uint32_t sparse_dense_ratio : {1, 16}) {
+        for (bool include_dense : {true, false}) {
+            fst::Trie trie(keys, include_dense, sparse_dense_ratio);
+
+            size_t i = 0;
+            for (auto it = trie.begin(); it.isValid(); it++, i++) {
+                REQUIRE_LT(i, keys.size());
+                REQUIRE_EQ(it.getKey(), keys[i]);
+                REQUIRE_EQ(it.getKeyId(), trie.exactSearch(keys[i]));
+            }
+            REQUIRE_EQ(i, keys.size());
+
+            for (const auto& query : others) {
+                auto it = trie.lowerBound(query);
+                auto expected = std::lower_bound(keys.begin(), keys.end(), query);
+                REQUIRE_EQ(it.isValid(), expected != keys.end());
+                if (it.isValid()) REQUIRE_EQ(it.getKey(), *expected);
+
+                const std::string prefix = query.substr(0, 3);
+                std::vector<std::string> results;
+                for (auto it = trie.predictiveSearch(prefix); it.isValid(); it++) results.push_back(it.getKey());
+                expected = std::lower_bound(keys.begin(), keys.end(), prefix);
+                for (const auto& result : results) {
+                    REQUIRE_EQ(result, *expected++);
+                }
+                REQUIRE((expected == keys.end() || expected->compare(0, prefix.length(), prefix) != 0));
+
+                std::vector<size_t> lengths;
+                trie.commonPrefixSearch(query, [&](fst::position_t key_id, size_t length) {
+                    REQUIRE_EQ(key_id, trie.exactSearch(query.substr(0, length)));
+                    lengths.push_back(length);
+                });
+                std::vector<size_t> expected_lengths;
+                for (size_t length = 0; length <= query.length(); length++) {
+                    if (std::binary_search(keys.begin(), keys.end(), query.substr(0, length))) {
+                        expected_lengths.push_back(length);
+                    }
+                }
+                REQUIRE_EQ(lengths, expected_lengths);
+            }
+        }
+    }
+}
+
+TEST_CASE("Test fst::Trie with deletions") {
+    auto keys = to_unique_vec(make_random_keys(10000, 1, 30, 'A', 'C'));
+    auto others = extract_keys(keys);
+
+    fst::Config config;
+    config.rank_select = true;
+    fst::Trie trie(keys, config);
+    std::vector<fst::position_t> key_ids(keys.size());
+    for (size_t i = 0; i < keys.size(); i++) {
+        key_ids[i] = trie.exactSearch(keys[i]);
+    }
+
+    std::vector<std::string> live_keys;
+    for (size_t i = 0; i < keys.size(); i++) {
+        if (i % 5 == 0) {
+            REQUIRE(trie.erase(keys[i]));
+            REQUIRE(!trie.erase(keys[i]));
+        } else {
+            live_keys.push_back(keys[i]);
+        }
+    }
+    REQUIRE(!trie.erase(others[0]));
+    REQUIRE_EQ(trie.getNumKeys(), live_keys.size());
+    REQUIRE_EQ(trie.getNumKeyIds(), keys.size());
+    REQUIRE_EQ(trie.getNumDeletedKeys(), keys.size() - live_keys.size());
+
+    for (size_t i = 0; i < keys.size(); i++) {
+        REQUIRE_EQ(trie.isDeleted(key_ids[i]), i % 5 == 0);
+        REQUIRE_EQ(trie.exactSearch(keys[i]), i % 5 == 0 ? fst::kNotFound : key_ids[i]);
+        // ranks count deleted keys as well
+        REQUIRE_EQ(trie.rank(keys[i]), i);
+        // traversals skip deleted keys
+        const auto it = trie.lowerBound(keys[i]);
+        const auto expected = std::lower_bound(live_keys.begin(), live_keys.end(), keys[i]);
+        REQUIRE_EQ(it.isValid(), expected != live_keys.end());
+        if (it.isValid()) REQUIRE_EQ(it.getKey(), *expected);
+        trie.commonPrefixSearch(keys[i], [&](fst::position_t key_id, size_t) { REQUIRE(!trie.isDeleted(key_id)); });
+    }
+    std::vector<std::string> traversed;
+    for (auto it = trie.begin(); it.isValid(); it++) {
+        traversed.push_back(it.getKey());
+    }
+    REQUIRE_EQ(traversed, live_keys);
+
+    // live key IDs renumber the live keys densely, in the order of key IDs
+    REQUIRE(!trie.hasLiveKeyIds());
+    trie.buildLiveKeyIds();
+    REQUIRE(trie.hasLiveKeyIds());
+    std::vector<fst::position_t> live_key_ids;
+    for (fst::position_t key_id = 0; key_id < trie.getNumKeyIds(); key_id++) {
+        if (!trie.isDeleted(key_id)) {
+            REQUIRE_EQ(trie.getLiveKeyId(key_id), live_key_ids.size());
+            live_key_ids.push_back(key_id);
+        }
+    }
+    REQUIRE_EQ(live_key_ids.size(), live_keys.size());
+
+    {
+        std::stringstream ss;
+        trie.save(ss);
+        fst::Trie loaded;
+        loaded.load(ss);
+        REQUIRE_EQ(loaded.getSizeIO(), trie.getSizeIO());
+        test_exact_search(loaded, live_keys, others);
+        for (size_t i = 0; i < keys.size(); i += 5) {
+            REQUIRE_EQ(loaded.exactSearch(keys[i]), fst::kNotFound);
+        }
+    }
+
+    // compaction rebuilds only past the threshold
+    REQUIRE(!trie.compact(config, 0.5));
+    REQUIRE_EQ(trie.getNumKeyIds(), keys.size());
+    trie.packIntoArena();
+    REQUIRE(trie.compact(config, 0.1));
+    REQUIRE(trie.isPacked());
+    REQUIRE_EQ(trie.getNumKeyIds(), live_keys.size());
+    REQUIRE_EQ(trie.getNumDeletedKeys(), 0);
+    test_exact_search(trie, live_keys, others);
+    for (fst::position_t i = 0; i < live_keys.size(); i++) {
+        REQUIRE_EQ(trie.rank(live_keys[i]), i);
+    }
+}
+
+TEST_CASE("Test fst::Trie set operations") {
+    auto keys = to_unique_vec(make_random_keys(10000, 1, 30, 'A', 'C'));
+
+    // overlapping key sets with many prefix keys, each with a few deleted keys
+    std::vector<std::string> keys_a, keys_b;
+    for (size_t i = 0; i < keys.size(); i++) {
+        if (i % 3 != 2) keys_a.push_back(keys[i]);
+        if (i % 3 != 0 || i % 7 == 0) keys_b.push_back(keys[i]);
+    }
+    std::vector<std::string> live_a, live_b;
+    for (size_t i = 0; i < keys_a.size(); i++) {
+        if (i % 11 != 0) live_a.push_back(keys_a[i]);
+    }
+    for (size_t i = 0; i < keys_b.size(); i++) {
+        if (i % 13 != 0) live_b.push_back(keys_b[i]);
+    }
+    std::vector<std::string> expected_and, expected_diff;
+    std::set_intersection(live_a.begin(), live_a.end(), live_b.begin(), live_b.end(),
+                          std::back_inserter(expected_and));
+    std::set_difference(live_a.begin(), live_a.end(), live_b.begin(), live_b.end(), std::back_inserter(expected_diff));
+
+    // dense and sparse nodes on either side, and leaves meeting nodes at every level
+    std::vector<fst::Config> configs(3);
+    configs[1].include_dense = false;
+    configs[2].sparse_dense_ratio = 1;
+    configs[2].inline_tail_bytes = 3;
+    configs[2].fingerprint_bits = 8;
+
+    for (const auto& config_a : configs) {
+        fst::Trie trie_a(keys_a, config_a);
+        for (size_t i = 0; i < keys_a.size(); i += 11) {
+            REQUIRE(trie_a.erase(keys_a[i]));
+        }
+        for (const auto& config_b : configs) {
+            fst::Trie trie_b(keys_b, config_b);
+            for (size_t i = 0; i < keys_b.size(); i += 13) {
+                REQUIRE(trie_b.erase(keys_b[i]));
+            }
+
+            std::vector<std::string> results;
+            trie_a.intersect(trie_b, [&](const std::string& key, fst::position_t key_id, fst::position_t other_key_id) {
+                REQUIRE_EQ(trie_a.exactSearch(key), key_id);
+                REQUIRE_EQ(trie_b.exactSearch(key), other_key_id);
+                results.push_back(key);
+            });
+            REQUIRE_EQ(results, expected_and);
+
+            results.clear();
+            trie_a.difference(trie_b, [&](const std::string& key, fst::position_t key_id) {
+                REQUIRE_EQ(trie_a.exactSearch(key), key_id);
+                results.push_back(key);
+            });
+            REQUIRE_EQ(results, expected_diff);
+        }
+    }
+
+    fst::Trie trie(keys), empty;
+    size_t count = 0;
+    trie.intersect(empty, [&](const std::string&, fst::position_t, fst::position_t) { count++; });
+    empty.difference(trie, [&](const std::string&, fst::position_t) { count++; });
+    REQUIRE_EQ(count, 0);
+    trie.difference(empty, [&](const std::string&, fst::position_t) { count++; });
+    REQUIRE_EQ(count, keys.size());
+}
+
+TEST_CASE("Test fst::Trie with rank and select") {
+    for (auto max_c : {'B', 'Z'}) {
+        auto keys = to_unique_vec(make_random_keys(10000, 1, 30, 'A', max_c));
+        auto others = extract_keys(keys);
+
+        for (bool include_dense : {false, true}) {
+            fst::Config config;
+            config.include_dense = include_dense;
+            config.sparse_dense_ratio = 16;
+            config.rank_select = true;
+            const fst::Trie trie(keys, config);
+            REQUIRE(trie.hasRankSelect());
+            REQUIRE(!fst::Trie(keys).hasRankSelect());
+
+            for (fst::position_t i = 0; i < keys.size(); i++) {
+                REQUIRE_EQ(trie.rank(keys[i]), i);
+                REQUIRE_EQ(trie.getKeyRank(trie.exactSearch(keys[i])), i);
+                auto it = trie.select(i);
+                REQUIRE(it.isValid());
+                REQUIRE_EQ(it.getKey(), keys[i]);
+            }
+            REQUIRE(!trie.select(fst::position_t(keys.size())).isValid());
+
+            // pagination from a selected key
+            auto it = trie.select(fst::position_t(keys.size() / 2));
+            for (size_t i = keys.size() / 2; i < keys.size() / 2 + 100; i++, it++) {
+                REQUIRE_EQ(it.getKey(), keys[i]);
+            }
+
+            for (size_t i = 0; i + 1 < others.size(); i++) {
+                const auto lb = std::lower_bound(keys.begin(), keys.end(), others[i]);
+                REQUIRE_EQ(trie.rank(others[i]), fst::position_t(lb - keys.begin()));
+
+                const std::string& left = std::min(others[i], others[i + 1]);
+                const std::string& right = std::max(others[i], others[i + 1]);
+                const auto count = std::lower_bound(keys.begin(), keys.end(), right) -
+                                   std::lower_bound(keys.begin(), keys.end(), left);
+                REQUIRE_EQ(trie.countRange(left, right), fst::position_t(count));
+            }
+            for (size_t i = 0; i < others.size() * 2; i++) {
+                const std::string& query = i % 2 == 0 ? others[i / 2] : keys[i * 7 % keys.size()];
+                for (size_t length = 0; length <= query.length(); length += 3) {
+                    const std::string prefix = query.substr(0, length);
+                    const auto count = std::lower_bound(keys.begin(), keys.end(), prefix + '\x7f') -
+                                       std::lower_bound(keys.begin(), keys.end(), prefix);
+                    REQUIRE_EQ(trie.countPrefix(prefix), fst::position_t(count));
+                }
+            }
+            REQUIRE_EQ(trie.countPrefix(""), keys.size());
+            REQUIRE_EQ(trie.rank(""), 0);
+            REQUIRE_EQ(trie.rank("\xff"), keys.size());
+
+            test_io(trie, keys, others);
+        }
+    }
+}
+
+TEST_CASE("Test fst::TopKCompleter") {
+    auto keys = to_unique_vec(make_random_keys(10000, 1, 30, 'A', 'D'));
+    fst::Config config;
+    config.rank_select = true;
+    const fst::Trie trie(keys, config);
+
+    std::mt19937 engine(13);
+    std::uniform_int_distribution<uint32_t> dist(0, 99);  // with many ties
+    std::vector<uint32_t> weights(keys.size());
+    std::vector<uint32_t> key_weights(keys.size());
+    for (size_t i = 0; i < keys.size(); i++) {
+        key_weights[i] = dist(engine);
+        weights[trie.exactSearch(keys[i])] = key_weights[i];
+    }
+    const fst::TopKCompleter completer(trie, weights);
+
+    for (size_t i = 0; i < keys.size(); i += 97) {
+        for (size_t length = 0; length <= 4 && length <= keys[i].length(); length++) {
+            const std::string prefix = keys[i].substr(0, length);
+            std::vector<std::pair<uint32_t, std::string>> expected;  // heaviest first, then in key order
+            for (size_t j = 0; j < keys.size(); j++) {
+                if (keys[j].compare(0, prefix.length(), prefix) == 0) {
+                    expected.emplace_back(key_weights[j], keys[j]);
+                }
+            }
+            std::stable_sort(expected.begin(), expected.end(),
+                             [](const auto& x, const auto& y) { return x.first > y.first; });
+
+            for (size_t k : {1, 10, 100}) {
+                const auto completions = completer.topK(prefix, k);
+                REQUIRE_EQ(completions.size(), std::min(k, expected.size()));
+                for (size_t j = 0; j < completions.size(); j++) {
+                    REQUIRE_EQ(completions[j].key, expected[j].second);
+                    REQUIRE_EQ(completions[j].weight, expected[j].first);
+                    REQUIRE_EQ(completions[j].key_id, trie.exactSearch(expected[j].second));
+                }
+            }
+        }
+    }
+    REQUIRE(completer.topK("E", 10).empty());
+}
+
+TEST_CASE("Test fst::Trie with root jump table") {
+    auto keys = to_unique_vec(make_random_keys(10000, 1, 30, 'A', 'D'));
+    keys.push_back("a");
+    auto others = extract_keys(keys);
+    others.push_back("ab");
+    others.push_back("ZZZ");
+
+    for (uint32_t sparse_dense_ratio : {1, 4, 16, 64}) {
+        for (bool include_dense : {true, false}) {
+            fst::Trie trie(keys, include_dense, sparse_dense_ratio);
+            std::vector<fst::position_t> expected;
+            for (const auto& key : keys) {
+                expected.push_back(trie.exactSearch(key));
+            }
+            REQUIRE(trie.buildRootJumpTable());
+            REQUIRE(trie.hasRootJumpTable());
+            test_exact_search(trie, keys, others);
+            for (size_t i = 0; i < keys.size(); i++) {
+                REQUIRE_EQ(trie.exactSearch(keys[i]), expected[i]);
+            }
+            trie.clearRootJumpTable();
+            REQUIRE_FALSE(trie.hasRootJumpTable());
+        }
+    }
+}
+
+TEST_CASE("Test fst::Trie with huge-page allocation") {
+    for (auto policy : {surf::kAllocHugePage, surf::kAllocHugeTLB}) {
+        surf::setAllocPolicy(policy);
+
+        auto arr = surf::makeArray<uint64_t>(surf::kHugePageSize / 4);
+        REQUIRE_EQ(reinterpret_cast<uintptr_t>(arr.get()) % surf::kHugePageSize, 0);
+        REQUIRE_EQ(arr.get_deleter().mapped_bytes, surf::kHugePageSize * 2);
+        REQUIRE(std::all_of(arr.get(), arr.get() + surf::kHugePageSize / 4, [](uint64_t x) { return x == 0; }));
+
+        auto keys = to_unique_vec(make_random_keys(10000, 1, 30, 'A', 'Z'));
+        auto others = extract_keys(keys);
+
+        fst::Trie trie(keys);
+        test_exact_search(trie, keys, others);
+        test_io(trie, keys, others);
+    }
+    surf::setAllocPolicy(surf::kAllocDefault);
+}
+
+TEST_CASE("Test fst::Trie packed into an arena") {
+    auto keys = to_unique_vec(make_random_keys(10000, 1, 30, 'A', 'Z'));
+    auto others = extract_keys(keys);
+
+    for (bool include_dense : {false, true}) {
+        fst::Trie trie(keys, include_dense, 16);
+        const uint64_t memory_usage = trie.getMemoryUsage();
+        REQUIRE(trie.buildRootJumpTable());
+
+        REQUIRE(!trie.isPacked());
+        trie.packIntoArena();
+        REQUIRE(trie.isPacked());
+        REQUIRE(trie.hasRootJumpTable());
+        test_exact_search(trie, keys, others);
+
+        trie.clearRootJumpTable();
+        REQUIRE_EQ(trie.getMemoryUsage(), memory_usage);
+        trie.packIntoArena();  // repacking drops the space of the table
+        test_exact_search(trie, keys, others);
+
+        fst::Trie moved = std::move(trie);
+        REQUIRE(moved.isPacked());
+        test_exact_search(moved, keys, others);
+        test_io(moved, keys, others);
+    }
+}
+
+TEST_CASE("Test fst::Trie round trip under each allocation mode") {
+    // The tail buffer (and the arena) exceed kHugePageSize, so that they are mapped by the
+    // huge-page policies, and a packed trie holds borrowed arrays.
+    auto keys = to_unique_vec(make_random_keys(200000, 16, 40, 'A', 'Z'));
+    auto others = extract_keys(keys);
+
+    fst::Config config;
+    config.rank_select = true;
+    config.bloom_bits_per_key = 8;
+    for (auto policy : {surf::kAllocDefault, surf::kAllocHugePage, surf::kAllocHugeTLB}) {
+        for (bool pack : {false, true}) {
+            surf::setAllocPolicy(policy);
+            fst::Trie trie(keys, config);
+            REQUIRE_GE(trie.getSuffixBytes(), surf::kHugePageSize);
+            if (pack) {
+                trie.packIntoArena();
+                REQUIRE(trie.isPacked());
+            }
+            test_exact_search(trie, keys, others);
+
+            fst::Trie moved = std::move(trie);
+            REQUIRE_EQ(moved.isPacked(), pack);
+            test_exact_search(moved, keys, others);
+            test_io(moved, keys, others);  // loaded into arrays of the same policy, unpacked
+        }
+    }
+    surf::setAllocPolicy(surf::kAllocDefault);
+}
+
+TEST_CASE("Test fst::Trie with traversal stats") {
+    auto keys = to_unique_vec(make_random_keys(10000, 1, 30, 'A', 'Z'));
+    auto others = extract_keys(keys);
+
+    using stats_t = surf::TraversalStats;
+
+    for (bool include_dense : {false, true}) {
+        fst::Trie trie(keys, include_dense, 16);
+
+        stats_t stats;
+        for (const auto& key : keys) {
+            REQUIRE_EQ(trie.exactSearch(key, stats), trie.exactSearch(key));
+            REQUIRE_GE(stats.getLastCount(stats_t::kTailBytes), 1);
+        }
+        stats_t others_stats;
+        for (const auto& key : others) {
+            REQUIRE_EQ(trie.exactSearch(key, others_stats), fst::kNotFound);
+        }
+        stats.merge(others_stats);
+
+        REQUIRE_EQ(stats.getNumQueries(), keys.size() + others.size());
+        REQUIRE_EQ(stats.getHistogram(stats_t::kRootJumps).getSum(), 0);
+        if (include_dense) {
+            REQUIRE_GT(stats.getHistogram(stats_t::kDenseLevels).getSum(), 0);
+        } else {
+            REQUIRE_EQ(stats.getHistogram(stats_t::kDenseLevels).getSum(), 0);
+        }
+        REQUIRE_GT(stats.getHistogram(stats_t::kSparseLevels).getSum(), 0);
+        REQUIRE_GT(stats.getHistogram(stats_t::kRankCalls).getSum(), 0);
+
+        // every sparse level runs one label search
+        uint64_t num_searches = 0;
+        for (auto c : {stats_t::kLinearSearches, stats_t::kBinarySearches, stats_t::kSimdSearches}) {
+            num_searches += stats.getHistogram(c).getSum();
+        }
+        REQUIRE_EQ(num_searches, stats.getHistogram(stats_t::kSparseLevels).getSum());
+
+        std::ostringstream oss;
+        stats.dump(oss);
+        REQUIRE_NE(oss.str().find("\"tail_bytes\": {\"count\": " + std::to_string(stats.getNumQueries())),
+                   std::string::npos);
+
+        REQUIRE(trie.buildRootJumpTable());
+        stats.reset();
+        for (const auto& key : keys) {
+            REQUIRE_EQ(trie.exactSearch(key, stats), trie.exactSearch(key));
+        }
+        REQUIRE_GT(stats.getHistogram(stats_t::kRootJumps).getSum(), 0);
+    }
+}
+
+TEST_CASE("Test fst::HotKeyCache") {
+    auto keys = to_unique_vec(make_random_keys(10000, 1, 50, 'A', 'Z'));
+    auto others = extract_keys(keys);
+
+    fst::Trie trie(keys);
+    fst::HotKeyCache cache(trie, 1024);
+    REQUIRE_EQ(cache.getCapacity(), 1024);
+
+    for (int run = 0; run < 2; run++) {
+        for (size_t i = 0; i < 2000; i++) {
+            REQUIRE_EQ(cache.exactSearch(keys[i % 500]), trie.exactSearch(keys[i % 500]));
+            REQUIRE_EQ(cache.exactSearch(others[i % 50]), fst::kNotFound);
+        }
+    }
+    REQUIRE_GT(cache.getHits(), cache.getMisses());
+
+    std::vector<std::thread> threads;
+    std::vector<int> errors(4, 0);
+    for (int t = 0; t < 4; t++) {
+        threads.emplace_back([&, t]() {
+            for (size_t i = 0; i < keys.size(); i++) {
+                const std::string& key = keys[(i * (t + 1)) % keys.size()];
+                errors[t] += cache.exactSearch(key) != trie.exactSearch(key);
+            }
+        });
+    }
+    for (auto& th : threads) {
+        th.join();
+    }
+    for (int t = 0; t < 4; t++) {
+        REQUIRE_EQ(errors[t], 0);
+    }
+
+    cache.resetCounters();
+    cache.clear();
+    REQUIRE_EQ(cache.getHits(), 0);
+    REQUIRE_EQ(cache.exactSearch(keys[0]), trie.exactSearch(keys[0]));
+    REQUIRE_EQ(cache.getMisses(), 1);
+}
+
+TEST_CASE("Test fst::Filter") {
+    auto keys = to_unique_vec(make_random_keys(10000, 1, 30, 'A', 'Z'));
+    auto others = extract_keys(keys);
+    const std::set<std::string> key_set(keys.begin(), keys.end());
+
+    std::vector<fst::FilterConfig> configs;
+    for (auto type : {surf::kNone, surf::kHash, surf::kReal, surf::kMixed}) {
+        for (bool include_dense : {true, false}) {
+            fst::FilterConfig config;
+            config.include_dense = include_dense;
+            config.sparse_dense_ratio = 16;
+            config.suffix_type = type;
+            config.hash_suffix_len = type == surf::kHash ? 8 : (type == surf::kMixed ? 4 : 0);
+            config.real_suffix_len = type == surf::kReal ? 8 : (type == surf::kMixed ? 4 : 0);
+            configs.push_back(config);
+        }
+    }
+
+    std::mt19937_64 engine(13);
+    std::uniform_int_distribution<size_t> dist(0, others.size() - 1);
+
+    for (const auto& config : configs) {
+        fst::Filter filter(keys, config);
+        REQUIRE_EQ(filter.getNumKeys(), keys.size());
+
+        for (const auto& key : keys) {
+            REQUIRE(filter.lookupKey(key));
+        }
+        size_t num_fps = 0;
+        for (const auto& other : others) {
+            num_fps += filter.lookupKey(other);
+        }
+        if (config.hash_suffix_len != 0) {
+            REQUIRE_LT(num_fps, others.size() / 20);
+        }
+
+        // no false negatives for ranges, while real suffix bits reject some empty ones
+        size_t num_rejects = 0;
+        for (size_t i = 0; i < 2000; i++) {
+            std::string left = others[dist(engine)];
+            std::string right = left;
+            right.back() += 1;
+            const bool left_incl = i % 2 == 0, right_incl = i % 4 < 2;
+            auto it = left_incl ? key_set.lower_bound(left) : key_set.upper_bound(left);
+            const bool exists = it != key_set.end() && (right_incl ? *it <= right : *it < right);
+            const bool result = filter.lookupRange(left, left_incl, right, right_incl);
+            if (exists) {
+                REQUIRE(result);
+            }
+            num_rejects += !result;
+        }
+        if (config.real_suffix_len != 0) {
+            REQUIRE_GT(num_rejects, 0);
+        }
+
+        std::stringstream ss;
+        filter.save(ss);
+        fst::Filter loaded;
+        loaded.load(ss);
+        REQUIRE_EQ(loaded.getNumKeys(), filter.getNumKeys());
+        REQUIRE_EQ(loaded.getMemoryUsage(), filter.getMemoryUsage());
+        for (size_t i = 0; i < others.size(); i++) {
+            REQUIRE_EQ(loaded.lookupKey(others[i]), filter.lookupKey(others[i]));
+            REQUIRE_EQ(loaded.lookupKey(keys[i]), true);
+        }
+    }
+}